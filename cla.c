@@ -9,13 +9,30 @@
 
 #define DEBUG // 定義 DEBUG 宏，用於除錯
 
+#ifndef HOST_SIM // 主機端模擬由編譯參數 (-DEULER 或 -DIMPROVEDEULER) 選擇積分法
 #define EULER // 定義 EULER 宏，使用歐拉法進行數值積分
 //#define IMPROVEDEULER // 註解掉 IMPROVEDEULER 宏，不使用改良型歐拉法
+#endif
 
 #define sample 5   // 定義每個切換週期的取樣點數
 #define window 1500 // 定義觀察的切換週期數
 #define length sample*window // 定義總資料長度
 
+// 規格存取：固定規格模式下 L, C, r_L, r_C, f 於編譯時折疊成常數，
+// 只有 R, v_i, duty 仍由 CPU 在執行時提供
+#ifdef FIXEDSPECS
+#define FIXED_DT    (1.0 / FIXED_f / sample)              // 固定時間步長
+#define SPEC_r_L    ((float)FIXED_r_L)                     // 電感 ESR
+#define SPEC_r_C    ((float)FIXED_r_C)                     // 電容 ESR
+#define INTEG_L(v)  ((v) * (float)(FIXED_DT / FIXED_L))    // 電感電壓 -> 電流增量
+#define INTEG_C(i)  ((i) * (float)(FIXED_DT / FIXED_C))    // 電容電流 -> 電壓增量
+#else
+#define SPEC_r_L    buckSPECS.r_L
+#define SPEC_r_C    buckSPECS.r_C
+#define INTEG_L(v)  ((v) / buckSPECS.L * dt)
+#define INTEG_C(i)  ((i) / buckSPECS.C * dt)
+#endif
+
 //
 // Globals
 //
@@ -58,8 +75,8 @@ __interrupt void Cla1Task1 ( void )
     DAC_I_L = buckState_i_L_step;
 
     // 若負載有變，重新計算等效電阻
-    rC_p_R = parallelAnB(buckSPECS.r_C, buckSPECS.R);
-    rC_s_R = seriesAnB(buckSPECS.r_C, buckSPECS.R);
+    rC_p_R = parallelAnB(SPEC_r_C, buckSPECS.R);
+    rC_s_R = seriesAnB(SPEC_r_C, buckSPECS.R);
 
 
 #ifdef EULER
@@ -68,13 +85,13 @@ __interrupt void Cla1Task1 ( void )
     if(prdCTR<(int)(buckInput.duty*sample)){
         // Q On 狀態方程式
         // 計算電感電壓
-        buckOutput_v_L = (- (buckSPECS.r_L + rC_p_R)*buckState_i_L_step
+        buckOutput_v_L = (- (SPEC_r_L + rC_p_R)*buckState_i_L_step
                         - (buckSPECS.R / rC_s_R)*buckState_v_C_step
                         + buckInput.v_i );
 
         // 計算下一步的電感電流
         buckState_i_L_nextStep = buckState_i_L_step +
-                                buckOutput_v_L / buckSPECS.L * dt;
+                                INTEG_L(buckOutput_v_L);
 
         // 計算電容電流
         buckOutput_i_C = ( (buckSPECS.R / rC_s_R)*buckState_i_L_step
@@ -82,18 +99,18 @@ __interrupt void Cla1Task1 ( void )
 
         // 計算下一步的電容電壓
         buckState_v_C_nextStep = buckState_v_C_step +
-                                buckOutput_i_C / buckSPECS.C * dt;
+                                INTEG_C(buckOutput_i_C);
     }
     // 判斷目前是否為開關關斷 (Off) 狀態
     else if(prdCTR>=(int)(buckInput.duty*sample)) {
         // Q Off 狀態方程式
         // 計算電感電壓
-        buckOutput_v_L = (- (buckSPECS.r_L + rC_p_R)*buckState_i_L_step
+        buckOutput_v_L = (- (SPEC_r_L + rC_p_R)*buckState_i_L_step
                         - (buckSPECS.R / rC_s_R)*buckState_v_C_step);
 
         // 計算下一步的電感電流
         buckState_i_L_nextStep = buckState_i_L_step +
-                                buckOutput_v_L / buckSPECS.L * dt;
+                                INTEG_L(buckOutput_v_L);
 
         // 計算電容電流
         buckOutput_i_C = ( (buckSPECS.R / rC_s_R)*buckState_i_L_step
@@ -101,7 +118,7 @@ __interrupt void Cla1Task1 ( void )
 
         // 計算下一步的電容電壓
         buckState_v_C_nextStep = buckState_v_C_step +
-                                buckOutput_i_C / buckSPECS.C * dt;
+                                INTEG_C(buckOutput_i_C);
     }
 
     // 確保電感電流不為負值
@@ -110,57 +127,58 @@ __interrupt void Cla1Task1 ( void )
 
 #ifdef IMPROVEDEULER
 // 改良型歐拉法 (Improved Euler method)
+// 先以目前值求出 i_L 與 v_C 的預測值，兩個校正值都必須使用同一組預測值
     if(prdCTR<(int)(buckInput.duty*sample)){
         debug();
         // Q On 狀態
         // 預測值
-        buckOutput_v_L = (- (buckSPECS.r_L + rC_p_R)*buckState_i_L_step
+        buckOutput_v_L = (- (SPEC_r_L + rC_p_R)*buckState_i_L_step
                         - (buckSPECS.R / rC_s_R)*buckState_v_C_step
                         + buckInput.v_i );
-        buckState_i_L_nextStep = buckState_i_L_step +
-                                buckOutput_v_L / buckSPECS.L * dt;
         buckOutput_i_C = ( (buckSPECS.R / rC_s_R)*buckState_i_L_step
                         - (1 / rC_s_R)*buckState_v_C_step );
+        buckState_i_L_nextStep = buckState_i_L_step +
+                                INTEG_L(buckOutput_v_L);
         buckState_v_C_nextStep = buckState_v_C_step +
-                                buckOutput_i_C / buckSPECS.C * dt;
+                                INTEG_C(buckOutput_i_C);
+        if(buckState_i_L_nextStep < 0) buckState_i_L_nextStep = 0;
         // 校正值
-        buckOutput_v_L += (- (buckSPECS.r_L + rC_p_R)*buckState_i_L_nextStep
+        buckOutput_v_L += (- (SPEC_r_L + rC_p_R)*buckState_i_L_nextStep
                         - (buckSPECS.R / rC_s_R)*buckState_v_C_nextStep
                         + buckInput.v_i );
-        buckOutput_v_L /= 2;
-        buckState_i_L_nextStep = buckState_i_L_step +
-                                buckOutput_v_L / buckSPECS.L * dt;
         buckOutput_i_C += ( (buckSPECS.R / rC_s_R)*buckState_i_L_nextStep
                         - (1 / rC_s_R)*buckState_v_C_nextStep );
+        buckOutput_v_L /= 2;
         buckOutput_i_C /= 2;
+        buckState_i_L_nextStep = buckState_i_L_step +
+                                INTEG_L(buckOutput_v_L);
         buckState_v_C_nextStep = buckState_v_C_step +
-                                buckOutput_i_C / buckSPECS.C * dt;
+                                INTEG_C(buckOutput_i_C);
     }
     else if(prdCTR>=(int)(buckInput.duty*sample)) {
         debug();
         // Q Off 狀態
         // 預測值
-        buckOutput_v_L = (- (buckSPECS.r_L + rC_p_R)*buckState_i_L_step
+        buckOutput_v_L = (- (SPEC_r_L + rC_p_R)*buckState_i_L_step
                         - (buckSPECS.R / rC_s_R)*buckState_v_C_step);
-        buckState_i_L_nextStep = buckState_i_L_step +
-                                buckOutput_v_L / buckSPECS.L * dt;
-        // 校正值
-        buckOutput_v_L += (- (buckSPECS.r_L + rC_p_R)*buckState_i_L_nextStep
-                        - (buckSPECS.R / rC_s_R)*buckState_v_C_nextStep);
-        buckOutput_v_L /= 2;
-        buckState_i_L_nextStep = buckState_i_L_step +
-                                buckOutput_v_L / buckSPECS.L * dt;
-        // 預測值
         buckOutput_i_C = ( (buckSPECS.R / rC_s_R)*buckState_i_L_step
                         - (1 / rC_s_R)*buckState_v_C_step );
+        buckState_i_L_nextStep = buckState_i_L_step +
+                                INTEG_L(buckOutput_v_L);
         buckState_v_C_nextStep = buckState_v_C_step +
-                                buckOutput_i_C / buckSPECS.C * dt;
+                                INTEG_C(buckOutput_i_C);
+        if(buckState_i_L_nextStep < 0) buckState_i_L_nextStep = 0;
         // 校正值
-        buckOutput_i_C = ( (buckSPECS.R / rC_s_R)*buckState_i_L_nextStep
+        buckOutput_v_L += (- (SPEC_r_L + rC_p_R)*buckState_i_L_nextStep
+                        - (buckSPECS.R / rC_s_R)*buckState_v_C_nextStep);
+        buckOutput_i_C += ( (buckSPECS.R / rC_s_R)*buckState_i_L_nextStep
                         - (1 / rC_s_R)*buckState_v_C_nextStep );
+        buckOutput_v_L /= 2;
         buckOutput_i_C /= 2;
+        buckState_i_L_nextStep = buckState_i_L_step +
+                                INTEG_L(buckOutput_v_L);
         buckState_v_C_nextStep = buckState_v_C_step +
-                                buckOutput_i_C / buckSPECS.C * dt;
+                                INTEG_C(buckOutput_i_C);
     }
 
     if(buckState_i_L_nextStep < 0) buckState_i_L_nextStep = 0;
@@ -226,10 +244,14 @@ __interrupt void Cla1Task8 ( void )
     // 初始化切換週期計數器
     prdCTR = 0;
     // 計算等效電阻
-    rC_p_R = parallelAnB(buckSPECS.r_C, buckSPECS.R);
-    rC_s_R = seriesAnB(buckSPECS.r_C, buckSPECS.R);
+    rC_p_R = parallelAnB(SPEC_r_C, buckSPECS.R);
+    rC_s_R = seriesAnB(SPEC_r_C, buckSPECS.R);
     // 計算時間步長
+#ifdef FIXEDSPECS
+    dt = FIXED_DT;
+#else
     dt = 1.0 / buckSPECS.f / sample;
+#endif
     // 觸發除錯中斷點，通知 CPU 初始化完成
     __mdebugstop();
 
@@ -0,0 +1,18 @@
+//
+// 固定規格 (FIXEDSPECS 模式)
+// 這些數值在編譯時折疊進 Cla1Task1，變更後須重新編譯 CPU 與 CLA 程式
+//
+#ifndef FIXEDSPECS_H
+#define FIXEDSPECS_H
+
+#define FIXED_L   100e-6 // H, 電感值
+#define FIXED_C   100e-6 // F, 電容值
+#define FIXED_r_L 10e-3  // ohm, 電感的等效串聯電阻 (ESR)
+#define FIXED_r_C 1e-3   // ohm, 電容的等效串聯電阻 (ESR)
+#define FIXED_f   100e3  // Hz, 切換頻率
+
+#endif // FIXEDSPECS_H
+
+//
+// End of file
+//
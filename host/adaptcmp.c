@@ -0,0 +1,200 @@
+//
+// Included Files
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "hostsim.h"
+#include "adaptive.h"
+
+//
+// Defines
+//
+#define PROFILE_END    2.0    // s, 模擬長度
+#define PROFILE_HOLD   20e-3  // s, 每段負載持續時間
+#define LOAD_HEAVY     5.0    // ohm, 重載 (CCM)
+#define LOAD_LIGHT     50.0   // ohm, 輕載 (DCM)
+#define VIN_LOW        3.0    // V, 每四段中一段輕載的輸入電壓，低於 v_C，導通期間 i_L 仍保持為零
+
+//
+// Globals
+//
+static const double tolerances[] = { 1e-3, 1e-6, 1e-9 }; // 可變步長的誤差容許值
+static const int substeps[] = { 1, 2, 4, 8 };            // 固定步長 RK4 每個時間步的子步數
+#define N_TOL  (int)(sizeof(tolerances) / sizeof(tolerances[0]))
+#define N_SUB  (int)(sizeof(substeps) / sizeof(substeps[0]))
+
+static long nPeriods;           // 比較點數 (每個切換週期起點一點)
+static double *refIL, *refVC;   // 參考模型在比較點的狀態
+static double *runIL, *runVC;   // 受測方法在比較點的狀態
+
+//
+// Function Prototypes
+//
+static void profileApply(double);                        // 套用負載與輸入電壓曲線
+static void report(const char*, long, double, double*);  // 印出一列結果並回傳最大誤差
+
+//
+// Main
+//
+// 比較固定步長 CLA 模型、固定步長雙精度 RK4 與可變步長積分器在長時間負載曲線下的精確度與速度
+// 負載每 20 ms 在 CCM 與 DCM 之間切換，比較點為每個切換週期的起點
+// 最後以相同精確度比較可變步長積分器與固定步長 RK4 的執行時間
+//
+int main(void)
+{
+    const ejHostScenario* sc = &ejHostScenarios[0];
+    ejBuckRefState ref;
+    double t0, t1, T, D, h;
+    double subErr[N_SUB], subWall[N_SUB], tolErr[N_TOL], tolWall[N_TOL];
+    long k, n, p;
+    int sample, i, j;
+
+    ejHostInit(&sc->specs, &sc->input);
+    T = 1.0 / buckSPECS.f;
+    D = ejHostOnFraction();
+    sample = (int)(T / dt + 0.5);
+    // 雙精度模型以 T/sample 為步長，切換邊緣與可變步長積分器的 k*T + tOn 完全一致
+    // (以 float 的 dt 前進時邊緣會逐漸偏移，造成約 3e-8 A 的誤差下限)
+    h = T / sample;
+    n = (long)(PROFILE_END / dt + 0.5);
+    nPeriods = n / sample;
+    refIL = malloc(nPeriods * sizeof(double));
+    refVC = malloc(nPeriods * sizeof(double));
+    runIL = malloc(nPeriods * sizeof(double));
+    runVC = malloc(nPeriods * sizeof(double));
+    if(!refIL || !refVC || !runIL || !runVC){
+        free(refIL);
+        free(refVC);
+        free(runIL);
+        free(runVC);
+        return 1;
+    }
+
+    printf("profile %.3f s, R %.0f/%.0f ohm every %.0f ms (v_i %.0f V in every 4th segment), "
+           "%ld periods, on fraction %.3f\n", PROFILE_END, LOAD_HEAVY, LOAD_LIGHT,
+           PROFILE_HOLD*1e3, VIN_LOW, nPeriods, D);
+    printf("%-22s %10s %9s %12s %12s %10s\n", "method", "steps", "steps/T",
+           "err_i_L", "err_v_C", "wall ms");
+
+    // 雙精度參考模型 (固定步長 RK4，每個時間步 64 個子步，過零點以割線法定位)
+    ejBuckRefInit(&ref);
+    t0 = ejHostNow();
+    for(k = 0; k < n; k++){
+        if(k % sample == 0){
+            refIL[k / sample] = ref.i_L;
+            refVC[k / sample] = ref.v_C;
+        }
+        profileApply((k / sample)*T);
+        ejBuckRefStep(&ref, &buckSPECS, &buckInput, (k % sample) < D*sample, h);
+    }
+    t1 = ejHostNow();
+    for(p = 0; p < nPeriods; p++){ runIL[p] = refIL[p]; runVC[p] = refVC[p]; }
+    report("fixed RK4 reference", n*64, (t1 - t0)*1e3, 0);
+
+    // 固定步長 CLA 模型
+    ejHostInit(&sc->specs, &sc->input);
+    t0 = ejHostNow();
+    for(k = 0; k < n; k++){
+        if(k % sample == 0){
+            runIL[k / sample] = buckState_i_L_step;
+            runVC[k / sample] = buckState_v_C_step;
+        }
+        profileApply((k / sample)*T);
+        ejHostStep();
+    }
+    t1 = ejHostNow();
+    report("fixed " HOST_INTEGRATOR, n, (t1 - t0)*1e3, 0);
+
+    // 固定步長雙精度 RK4，與參考模型相同但子步數較少
+    for(j = 0; j < N_SUB; j++){
+        char name[32];
+
+        ejHostInit(&sc->specs, &sc->input);
+        ejBuckRefInit(&ref);
+        t0 = ejHostNow();
+        for(k = 0; k < n; k++){
+            if(k % sample == 0){
+                runIL[k / sample] = ref.i_L;
+                runVC[k / sample] = ref.v_C;
+            }
+            profileApply((k / sample)*T);
+            ejBuckRefStepN(&ref, &buckSPECS, &buckInput, (k % sample) < D*sample, h,
+                           substeps[j]);
+        }
+        t1 = ejHostNow();
+        subWall[j] = (t1 - t0)*1e3;
+        snprintf(name, sizeof(name), "fixed RK4 x%d", substeps[j]);
+        report(name, n*substeps[j], subWall[j], &subErr[j]);
+    }
+
+    // 可變步長積分器，逐週期前進 (週期起點本身就是切換邊緣，不會增加步數)
+    for(i = 0; i < N_TOL; i++){
+        ejAdaptive a;
+        char name[32];
+
+        ejHostInit(&sc->specs, &sc->input);
+        ejAdaptiveInit(&a, tolerances[i], tolerances[i]);
+        t0 = ejHostNow();
+        for(p = 0; p < nPeriods; p++){
+            runIL[p] = a.x.i_L;
+            runVC[p] = a.x.v_C;
+            profileApply(p*T);
+            ejAdaptiveRun(&a, &buckSPECS, &buckInput, D, (p + 1)*T);
+        }
+        t1 = ejHostNow();
+        snprintf(name, sizeof(name), "adaptive tol %.0e", tolerances[i]);
+        tolWall[i] = (t1 - t0)*1e3;
+        report(name, a.nAccept + a.nReject, tolWall[i], &tolErr[i]);
+        printf("%-22s %ld rejected, %ld edges, %ld i_L zero crossings, %ld DCM exits, "
+               "%ld evaluations\n", "", a.nReject, a.nEdges, a.nZeroCross, a.nDcmLeave,
+               a.nDeriv);
+    }
+
+    // 相同精確度下的執行時間：取誤差不大於可變步長結果的最少子步數 RK4
+    // 每個切換週期至少有兩個開關邊緣，可變步長積分器的步長受邊緣限制，
+    // 容許值寬鬆時誤差控制不會縮短步長，因此步數與容許值無關
+    printf("\nspeedup at matched accuracy (cheapest fixed RK4 with error <= adaptive):\n");
+    for(i = 0; i < N_TOL; i++){
+        for(j = 0; j < N_SUB && subErr[j] > tolErr[i]; j++);
+        if(j < N_SUB){
+            printf("  tol %.0e: err %.3e vs fixed RK4 x%d err %.3e, %.2f ms vs %.2f ms, "
+                   "speedup %.2fx%s\n", tolerances[i], tolErr[i], substeps[j], subErr[j],
+                   tolWall[i], subWall[j], subWall[j] / tolWall[i],
+                   tolWall[i] < subWall[j] ? "" : " (no wall-time gain)");
+        }
+        else{
+            printf("  tol %.0e: err %.3e, no fixed RK4 up to x%d is as accurate\n",
+                   tolerances[i], tolErr[i], substeps[N_SUB - 1]);
+        }
+    }
+
+    return 0;
+}
+
+// 負載曲線：重載與輕載每 PROFILE_HOLD 交替，每四段中的一段輕載把 v_i 降到 VIN_LOW，
+// 使 v_i 低於 v_C，檢查導通期間 i_L 保持為零與 v_C 降到 v_i 以下後重新導通
+// 所有方法都以切換週期起點的時間查詢，確保輸入在同一時刻改變
+static void profileApply(double t){
+    long seg = (long)(t / PROFILE_HOLD + 1e-9);
+    buckSPECS.R = (seg % 2) ? LOAD_LIGHT : LOAD_HEAVY;
+    buckInput.v_i = (seg % 4 == 3) ? VIN_LOW : ejHostScenarios[0].input.v_i;
+}
+
+// 印出一列結果：與參考模型在各比較點的最大誤差 (i_L、v_C 中較大者存入 err)
+static void report(const char* name, long steps, double wallMs, double* err){
+    double errIL = 0, errVC = 0;
+    long p;
+
+    for(p = 0; p < nPeriods; p++){
+        errIL = fmax(errIL, fabs(runIL[p] - refIL[p]));
+        errVC = fmax(errVC, fabs(runVC[p] - refVC[p]));
+    }
+    printf("%-22s %10ld %9.2f %12.3e %12.3e %10.2f\n", name, steps,
+           (double)steps / nPeriods, errIL, errVC, wallMs);
+    if(err) *err = fmax(errIL, errVC);
+}
+
+//
+// End of file
+//
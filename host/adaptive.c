@@ -0,0 +1,211 @@
+//
+// Included Files
+//
+#include <math.h>
+#include "adaptive.h"
+
+//
+// Defines
+//
+#define SAFETY      0.9   // 步長控制的安全係數
+#define FAC_MIN     0.2   // 步長最小縮放倍數
+#define FAC_MAX     5.0   // 步長最大縮放倍數
+#define ROOT_ITER   30    // 事件定位最多疊代次數
+#define EV_ZERO     0     // 事件：導通中的 i_L 降到零
+#define EV_LEAVE    1     // 事件：DCM 中 i_L 在零點的斜率轉為正 (重新導通)
+
+//
+// Function Prototypes
+//
+static void deriv(ejAdaptive*, const ejBuckRefState*, const ejBuckSPECS*,
+                  double, ejBuckRefState*);
+static double dpStep(ejAdaptive*, const ejBuckSPECS*, double, double,
+                     const ejBuckRefState*, ejBuckRefState*);
+static double zeroSlope(ejAdaptive*, const ejBuckRefState*, const ejBuckSPECS*, double);
+static double eventFn(ejAdaptive*, const ejBuckRefState*, const ejBuckSPECS*,
+                      double, int, double);
+static double locate(ejAdaptive*, const ejBuckSPECS*, double, double, int,
+                     ejBuckRefState*);
+
+//
+// Function Definitions
+//
+
+// 狀態歸零並設定誤差容許值
+void ejAdaptiveInit(ejAdaptive* a, double rtol, double atol){
+    ejBuckRefInit(&a->x);
+    a->t = 0.0;
+    a->rtol = rtol;
+    a->atol = atol;
+    a->h = 0.0;
+    a->dcm = 0;
+    a->nAccept = a->nReject = a->nEdges = a->nZeroCross = a->nDcmLeave = a->nDeriv = 0;
+}
+
+// 以固定規格與輸入積分到 tEnd
+// onFraction 為每個切換週期中開關導通的比例 (由週期起點開始)
+void ejAdaptiveRun(ejAdaptive* a, const ejBuckSPECS* s, const ejBuckInput* in,
+                   double onFraction, double tEnd){
+    double T = 1.0 / s->f;
+    double tOn = onFraction * T;
+
+    if(a->h <= 0.0) a->h = T / 10;
+
+    while(a->t < tEnd){
+        // 找出目前的開關區間與下一個切換邊緣
+        double k = floor(a->t / T + 1e-9);
+        int on = a->t < k*T + tOn - 1e-9*T;
+        double tEdge = on ? k*T + tOn : (k + 1)*T;
+        double tSeg = tEdge < tEnd ? tEdge : tEnd;
+        double v_i = on ? in->v_i : 0.0;
+
+        // 區間起點：i_L 為零時，零點斜率不為正則保持 DCM (例如導通但 v_i 低於 v_C)，否則開始導通
+        if(a->x.i_L <= 0.0){
+            a->x.i_L = 0.0;
+            a->dcm = zeroSlope(a, &a->x, s, v_i) <= 0.0;
+        }
+        else a->dcm = 0;
+
+        while(a->t < tSeg){
+            double h = a->h < tSeg - a->t ? a->h : tSeg - a->t;
+            double err, fac;
+            ejBuckRefState xNew;
+
+            // 剩餘時間太短時直接延伸到區間終點，避免產生極小的步長
+            if(tSeg - a->t - h < 1e-3*h) h = tSeg - a->t;
+
+            err = dpStep(a, s, v_i, h, &a->x, &xNew);
+            fac = err > 0.0 ? SAFETY*pow(err, -0.2) : FAC_MAX;
+            if(fac < FAC_MIN) fac = FAC_MIN;
+            if(fac > FAC_MAX) fac = FAC_MAX;
+
+            if(err > 1.0){
+                a->nReject++;
+                a->h = h*fac;
+                continue;
+            }
+
+            // 導通或關斷期間 i_L 穿越零點：定位過零時間並在該點結束此步，
+            // 之後零點斜率不為正則進入 DCM
+            if(!a->dcm && xNew.i_L < 0.0){
+                h = locate(a, s, v_i, h, EV_ZERO, &xNew);
+                xNew.i_L = 0.0;
+                a->dcm = zeroSlope(a, &xNew, s, v_i) <= 0.0;
+                a->nZeroCross++;
+            }
+            // DCM 期間 v_C 下降使零點斜率轉正：定位該時間並在該點離開 DCM
+            else if(a->dcm && zeroSlope(a, &xNew, s, v_i) > 0.0){
+                h = locate(a, s, v_i, h, EV_LEAVE, &xNew);
+                a->dcm = 0;
+                a->nDcmLeave++;
+            }
+            else{
+                a->h = h*fac;
+            }
+
+            a->x = xNew;
+            a->t = (tSeg - a->t - h <= 0.0) ? tSeg : a->t + h;
+            a->nAccept++;
+        }
+
+        if(tSeg == tEdge) a->nEdges++;
+    }
+}
+
+// 狀態方程式 (不含 i_L 的箝位，步內保持平滑)，DCM 期間 i_L 保持為零
+static void deriv(ejAdaptive* a, const ejBuckRefState* x, const ejBuckSPECS* s,
+                  double v_i, ejBuckRefState* dx){
+    ejBuckRefDeriv(x, s, v_i, 0, dx);
+    if(a->dcm) dx->i_L = 0.0;
+    a->nDeriv++;
+}
+
+// i_L 為零時的 di_L/dt (A/s)，決定 DCM 是否持續
+static double zeroSlope(ejAdaptive* a, const ejBuckRefState* x, const ejBuckSPECS* s,
+                        double v_i){
+    ejBuckRefState z = { 0.0, x->v_C }, dz;
+    ejBuckRefDeriv(&z, s, v_i, 0, &dz);
+    a->nDeriv++;
+    return dz.i_L;
+}
+
+// 事件函數：步首為非負、事件後為負，以 A 為單位 (斜率乘上步長)
+static double eventFn(ejAdaptive* a, const ejBuckRefState* x, const ejBuckSPECS* s,
+                      double v_i, int kind, double h){
+    return kind == EV_ZERO ? x->i_L : -zeroSlope(a, x, s, v_i)*h;
+}
+
+// 以 Illinois 法 (改良的試位法) 在 (0, h] 中定位事件，xNew 為事件時的狀態，回傳事件時間
+static double locate(ejAdaptive* a, const ejBuckSPECS* s, double v_i, double h, int kind,
+                     ejBuckRefState* xNew){
+    double hLo = 0.0, hHi = h, hs = h;
+    double fLo = eventFn(a, &a->x, s, v_i, kind, h), fHi = eventFn(a, xNew, s, v_i, kind, h);
+    int n, side = 0;
+
+    for(n = 0; n < ROOT_ITER; n++){
+        double f;
+        hs = hLo + (hHi - hLo) * fLo / (fLo - fHi);
+        dpStep(a, s, v_i, hs, &a->x, xNew);
+        f = eventFn(a, xNew, s, v_i, kind, h);
+        if(fabs(f) <= 1e-6*a->atol) break;
+        if(f > 0.0){
+            hLo = hs; fLo = f;
+            if(side == 1) fHi /= 2;
+            side = 1;
+        }
+        else{
+            hHi = hs; fHi = f;
+            if(side == -1) fLo /= 2;
+            side = -1;
+        }
+    }
+    return hs;
+}
+
+// Dormand-Prince 5(4) 單步，回傳以容許值正規化後的誤差估計 (<= 1 表示可接受)
+static double dpStep(ejAdaptive* a, const ejBuckSPECS* s, double v_i, double h,
+                     const ejBuckRefState* x, ejBuckRefState* xNew){
+    ejBuckRefState k1, k2, k3, k4, k5, k6, k7, y;
+    double eI, eV, scI, scV;
+
+    deriv(a, x, s, v_i, &k1);
+    y.i_L = x->i_L + h*(k1.i_L/5);
+    y.v_C = x->v_C + h*(k1.v_C/5);
+    deriv(a, &y, s, v_i, &k2);
+    y.i_L = x->i_L + h*(3.0/40*k1.i_L + 9.0/40*k2.i_L);
+    y.v_C = x->v_C + h*(3.0/40*k1.v_C + 9.0/40*k2.v_C);
+    deriv(a, &y, s, v_i, &k3);
+    y.i_L = x->i_L + h*(44.0/45*k1.i_L - 56.0/15*k2.i_L + 32.0/9*k3.i_L);
+    y.v_C = x->v_C + h*(44.0/45*k1.v_C - 56.0/15*k2.v_C + 32.0/9*k3.v_C);
+    deriv(a, &y, s, v_i, &k4);
+    y.i_L = x->i_L + h*(19372.0/6561*k1.i_L - 25360.0/2187*k2.i_L
+                        + 64448.0/6561*k3.i_L - 212.0/729*k4.i_L);
+    y.v_C = x->v_C + h*(19372.0/6561*k1.v_C - 25360.0/2187*k2.v_C
+                        + 64448.0/6561*k3.v_C - 212.0/729*k4.v_C);
+    deriv(a, &y, s, v_i, &k5);
+    y.i_L = x->i_L + h*(9017.0/3168*k1.i_L - 355.0/33*k2.i_L + 46732.0/5247*k3.i_L
+                        + 49.0/176*k4.i_L - 5103.0/18656*k5.i_L);
+    y.v_C = x->v_C + h*(9017.0/3168*k1.v_C - 355.0/33*k2.v_C + 46732.0/5247*k3.v_C
+                        + 49.0/176*k4.v_C - 5103.0/18656*k5.v_C);
+    deriv(a, &y, s, v_i, &k6);
+    // 五階解
+    xNew->i_L = x->i_L + h*(35.0/384*k1.i_L + 500.0/1113*k3.i_L + 125.0/192*k4.i_L
+                            - 2187.0/6784*k5.i_L + 11.0/84*k6.i_L);
+    xNew->v_C = x->v_C + h*(35.0/384*k1.v_C + 500.0/1113*k3.v_C + 125.0/192*k4.v_C
+                            - 2187.0/6784*k5.v_C + 11.0/84*k6.v_C);
+    deriv(a, xNew, s, v_i, &k7);
+
+    // 五階與四階解的差作為誤差估計
+    eI = h*(71.0/57600*k1.i_L - 71.0/16695*k3.i_L + 71.0/1920*k4.i_L
+            - 17253.0/339200*k5.i_L + 22.0/525*k6.i_L - 1.0/40*k7.i_L);
+    eV = h*(71.0/57600*k1.v_C - 71.0/16695*k3.v_C + 71.0/1920*k4.v_C
+            - 17253.0/339200*k5.v_C + 22.0/525*k6.v_C - 1.0/40*k7.v_C);
+    scI = a->atol + a->rtol*fmax(fabs(x->i_L), fabs(xNew->i_L));
+    scV = a->atol + a->rtol*fmax(fabs(x->v_C), fabs(xNew->v_C));
+
+    return fmax(fabs(eI) / scI, fabs(eV) / scV);
+}
+
+//
+// End of file
+//
@@ -0,0 +1,51 @@
+//
+// Included Files
+//
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include "hostsim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Globals
+//
+
+// 可變步長積分器 (Dormand-Prince 5(4) 嵌入式 RK)
+// 每個開關區間內的狀態方程式是平滑的線性系統，因此步長只受誤差控制，
+// 開關切換邊緣、i_L 過零點 (導通或關斷期間皆可能) 與 DCM 結束點都會被精確定位並作為步長的終點。
+// i_L 為零時，只要零點的 di_L/dt 不為正就保持為零，與 Cla1Task1 及參考模型的箝位一致
+typedef struct ejAdaptive {
+   ejBuckRefState x;  // 目前狀態
+   double t;          // s, 目前時間
+   double rtol;       // 相對誤差容許值
+   double atol;       // 絕對誤差容許值
+   double h;          // s, 下一步的建議步長
+   int dcm;           // 1: i_L 已降到零並保持 (DCM)
+   long nAccept;      // 接受的步數
+   long nReject;      // 拒絕的步數
+   long nEdges;       // 經過的開關切換邊緣數
+   long nZeroCross;   // 定位到的 i_L 過零點數
+   long nDcmLeave;    // 定位到的 DCM 結束點數 (區間中途重新導通)
+   long nDeriv;       // 狀態方程式求值次數
+} ejAdaptive;
+
+//
+// Function Prototypes
+//
+void ejAdaptiveInit(ejAdaptive*, double, double);  // 狀態歸零並設定誤差容許值
+void ejAdaptiveRun(ejAdaptive*, const ejBuckSPECS*,
+                   const ejBuckInput*, double, double); // 以固定規格與輸入積分到指定時間
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ADAPTIVE_H
+
+//
+// End of file
+//
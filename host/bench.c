@@ -0,0 +1,49 @@
+//
+// Included Files
+//
+#include <stdio.h>
+#include "hostsim.h"
+
+//
+// Defines
+//
+#define BENCH_STEPS  20000000L // 每輪執行的時間步數
+#define BENCH_ROUNDS 5         // 量測輪數，取最快的一輪
+
+//
+// Main
+//
+// 量測 Cla1Task1 的單步執行時間
+// 分別以一般模式與 -DFIXEDSPECS 編譯後比較兩者的結果
+//
+int main(void)
+{
+    const ejHostScenario* sc = &ejHostScenarios[0];
+    double best = 1e30, t0, t1;
+    long k;
+    int r;
+
+    for(r = 0; r < BENCH_ROUNDS; r++){
+        ejHostInit(&sc->specs, &sc->input);
+        t0 = ejHostNow();
+        for(k = 0; k < BENCH_STEPS; k++){
+            // 與 adca1_isr 相同，每個時間步都由 CPU 寫入負載與輸入電壓
+            buckSPECS.R = sc->specs.R;
+            buckInput.v_i = sc->input.v_i;
+            ejHostStep();
+        }
+        t1 = ejHostNow();
+        if(t1 - t0 < best) best = t1 - t0;
+    }
+
+    printf("integrator %s, specs %s: %.2f ns/step, %.1f Msteps/s "
+           "(i_L %.4f A, v_C %.4f V)\n", HOST_INTEGRATOR, HOST_SPECS,
+           best / BENCH_STEPS * 1e9, BENCH_STEPS / best * 1e-6,
+           buckState_i_L_step, buckState_v_C_step);
+
+    return 0;
+}
+
+//
+// End of file
+//
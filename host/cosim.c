@@ -0,0 +1,234 @@
+//
+// Included Files
+//
+#define _GNU_SOURCE
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "cosim.h"
+
+//
+// Defines
+//
+#define SPIN_LIMIT   4000       // futex 模式下休眠前的忙碌等待次數
+#define SPIN_POLL    (1L << 20) // spin 模式下每輪忙碌等待次數，之後回到呼叫端檢查對方狀態
+#define SPIN_YIELD   1024       // 每忙碌等待此次數讓出 CPU 一次
+#define POLL_NS      10000000L  // ns, futex 休眠上限，逾時後回到呼叫端檢查對方狀態
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpuRelax()   __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define cpuRelax()   __asm__ __volatile__("yield")
+#else
+#define cpuRelax()
+#endif
+
+//
+// Function Prototypes
+//
+static void waitChange(ejCosimRing*, uint32_t*, uint32_t, uint32_t*);
+static void publish(ejCosimRing*, uint32_t*, uint32_t, uint32_t*);
+static int peerAlive(int32_t);
+
+//
+// Function Definitions
+//
+
+// 模型端：建立共享記憶體並初始化環狀緩衝區
+ejCosimRing* ejCosimCreate(const char* name, int mode){
+    ejCosimRing* r;
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+    if(fd < 0) return 0;
+    if(ftruncate(fd, sizeof(ejCosimRing)) != 0){
+        close(fd);
+        return 0;
+    }
+    r = mmap(0, sizeof(ejCosimRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(r == MAP_FAILED) return 0;
+
+    memset(r, 0, sizeof(*r));
+    r->mode = mode;
+    r->plantPid = getpid();
+    // 最後寫入 magic，控制器以此判斷初始化完成
+    __atomic_store_n(&r->magic, COSIM_MAGIC, __ATOMIC_RELEASE);
+    return r;
+}
+
+// 控制器端：連接既有的共享記憶體，模型尚未建立完成時回傳 0 (可稍後重試)
+// 以 compare-exchange 從 0 取得 ctrlPid，已有其他控制器時回傳 0 並設定 errno 為 EBUSY
+ejCosimRing* ejCosimAttach(const char* name){
+    ejCosimRing* r;
+    int32_t none = 0;
+    struct stat st;
+    int fd = shm_open(name, O_RDWR, 0);
+
+    if(fd < 0) return 0;
+    // 模型可能還在 ftruncate 之前，大小不足時映射區會存取到檔案之外
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ejCosimRing)){
+        close(fd);
+        return 0;
+    }
+    r = mmap(0, sizeof(ejCosimRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(r == MAP_FAILED) return 0;
+    if(__atomic_load_n(&r->magic, __ATOMIC_ACQUIRE) != COSIM_MAGIC){
+        munmap(r, sizeof(ejCosimRing));
+        return 0;
+    }
+    if(!__atomic_compare_exchange_n(&r->ctrlPid, &none, (int32_t)getpid(), 0,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED)){
+        munmap(r, sizeof(ejCosimRing));
+        errno = EBUSY;
+        return 0;
+    }
+    return r;
+}
+
+// 解除映射
+void ejCosimDetach(ejCosimRing* r){
+    munmap(r, sizeof(ejCosimRing));
+}
+
+// 刪除共享記憶體名稱
+void ejCosimUnlink(const char* name){
+    shm_unlink(name);
+}
+
+// 控制器端：送出 n 個 tick 的輸入，超過環狀緩衝區剩餘空間時回傳 -1
+int ejCosimSubmit(ejCosimRing* r, const ejCosimSlot* in, uint32_t n){
+    uint32_t head = __atomic_load_n(&r->submitted, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&r->completed, __ATOMIC_ACQUIRE);
+    uint32_t k;
+
+    if(head - tail + n > COSIM_RING_SLOTS) return -1;
+    for(k = 0; k < n; k++){
+        ejCosimSlot* s = &r->slot[(head + k) & (COSIM_RING_SLOTS - 1)];
+        s->duty = in[k].duty;
+        s->v_i = in[k].v_i;
+        s->R = in[k].R;
+    }
+    __atomic_store_n(&r->submitted, head + n, __ATOMIC_RELEASE);
+    publish(r, &r->doorbell, __atomic_load_n(&r->doorbell, __ATOMIC_RELAXED) + 1, &r->plantWaiting);
+    return 0;
+}
+
+// 控制器端：等待所有已送出的 tick 完成，並取回最後 n 個 tick 的輸出
+// n 超過環狀緩衝區大小 (較舊的 tick 已被覆寫)、模型行程消失，或超過 timeout 秒 completed 都沒有前進時回傳 -1
+int ejCosimWait(ejCosimRing* r, ejCosimSlot* out, uint32_t n, double timeout){
+    uint32_t head = __atomic_load_n(&r->submitted, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&r->completed, __ATOMIC_ACQUIRE);
+    int32_t plantPid = __atomic_load_n(&r->plantPid, __ATOMIC_RELAXED);
+    double tProgress = 0;
+    uint32_t k;
+
+    if(n > COSIM_RING_SLOTS) return -1;
+    while(tail != head){
+        uint32_t now;
+
+        waitChange(r, &r->completed, tail, &r->ctrlWaiting);
+        now = __atomic_load_n(&r->completed, __ATOMIC_ACQUIRE);
+        if(now != tail){
+            tail = now;
+            tProgress = 0;
+            continue;
+        }
+        // 等待逾時：檢查模型是否還在，以及是否超過容許時間
+        if(!peerAlive(plantPid)) return -1;
+        if(timeout > 0){
+            if(tProgress == 0) tProgress = ejHostNow();
+            else if(ejHostNow() - tProgress > timeout) return -1;
+        }
+    }
+    for(k = 0; k < n; k++){
+        out[k] = r->slot[(head - n + k) & (COSIM_RING_SLOTS - 1)];
+    }
+    return 0;
+}
+
+// 控制器端：通知模型結束 (模型會先完成已送出的 tick)
+void ejCosimShutdown(ejCosimRing* r){
+    __atomic_store_n(&r->shutdown, 1, __ATOMIC_SEQ_CST);
+    publish(r, &r->doorbell, __atomic_load_n(&r->doorbell, __ATOMIC_RELAXED) + 1, &r->plantWaiting);
+}
+
+// 模型端：取出已送出的 tick，逐一執行 Cla1Task1 並寫回輸出
+// 等同 adca1_isr 中設定 buckInput/buckSPECS、執行 CLA 任務並讀取 DAC 變數的流程
+int ejCosimServe(ejCosimRing* r){
+    uint32_t tail = __atomic_load_n(&r->completed, __ATOMIC_RELAXED);
+
+    for(;;){
+        // 先讀 doorbell 再讀 submitted/shutdown，之後的送出或結束通知必定改變 doorbell
+        uint32_t bell = __atomic_load_n(&r->doorbell, __ATOMIC_ACQUIRE);
+        uint32_t head = __atomic_load_n(&r->submitted, __ATOMIC_ACQUIRE);
+
+        if(head == tail){
+            if(__atomic_load_n(&r->shutdown, __ATOMIC_ACQUIRE)) return 0;
+            if(!peerAlive(__atomic_load_n(&r->ctrlPid, __ATOMIC_ACQUIRE))) return -1;
+            waitChange(r, &r->doorbell, bell, &r->plantWaiting);
+            continue;
+        }
+        while(tail != head){
+            ejCosimSlot* s = &r->slot[tail & (COSIM_RING_SLOTS - 1)];
+            buckInput.duty = s->duty;
+            buckInput.v_i = s->v_i;
+            buckSPECS.R = s->R;
+            ejHostStep();
+            s->v_o = DAC_V_O;
+            s->i_L = DAC_I_L;
+            tail++;
+        }
+        publish(r, &r->completed, tail, &r->ctrlWaiting);
+    }
+}
+
+// 等待 word 離開 old，最多等待一輪 (spin 模式 SPIN_POLL 次，futex 模式 POLL_NS)
+// 呼叫端在回傳後重新檢查狀態，因此逾時或假喚醒都不影響正確性
+static void waitChange(ejCosimRing* r, uint32_t* word, uint32_t old, uint32_t* waiting){
+    struct timespec ts = { 0, POLL_NS };
+    long n, limit = r->mode == COSIM_SPIN ? SPIN_POLL : SPIN_LIMIT;
+
+    for(n = 1; n <= limit; n++){
+        if(__atomic_load_n(word, __ATOMIC_ACQUIRE) != old) return;
+        if(n % SPIN_YIELD == 0) sched_yield();
+        else cpuRelax();
+    }
+    if(r->mode == COSIM_SPIN) return;
+
+    // 先登記為等待者再檢查，與 publish 的「先寫入再檢查等待者」配對，避免遺失喚醒
+    __atomic_fetch_add(waiting, 1, __ATOMIC_SEQ_CST);
+    if(__atomic_load_n(word, __ATOMIC_SEQ_CST) == old){
+        syscall(SYS_futex, word, FUTEX_WAIT, old, &ts, 0, 0);
+    }
+    __atomic_fetch_sub(waiting, 1, __ATOMIC_SEQ_CST);
+}
+
+// 更新 word，若對方正在休眠則喚醒
+static void publish(ejCosimRing* r, uint32_t* word, uint32_t val, uint32_t* waiting){
+    if(r->mode == COSIM_SPIN){
+        __atomic_store_n(word, val, __ATOMIC_RELEASE);
+        return;
+    }
+    __atomic_store_n(word, val, __ATOMIC_SEQ_CST);
+    if(__atomic_load_n(waiting, __ATOMIC_SEQ_CST)){
+        syscall(SYS_futex, word, FUTEX_WAKE, 1, 0, 0, 0);
+    }
+}
+
+// 對方行程是否還在 (pid 為 0 表示尚未連接，視為存在)
+static int peerAlive(int32_t pid){
+    return pid == 0 || kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+//
+// End of file
+//
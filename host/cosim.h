@@ -0,0 +1,81 @@
+//
+// Included Files
+//
+#ifndef COSIM_H
+#define COSIM_H
+
+#include <stdint.h>
+#include "hostsim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Defines
+//
+#define COSIM_MAGIC        0x454A4353u // "EJCS"
+#define COSIM_RING_SLOTS   4096        // 環狀緩衝區的 tick 數 (須為 2 的次方)
+#define COSIM_SPIN         0           // 交接方式：忙碌等待
+#define COSIM_FUTEX        1           // 交接方式：短暫忙碌等待後以 futex 休眠
+
+//
+// Globals
+//
+
+// 每個 tick 的輸入與輸出，取代 main.c 中 EPWMDuty/eCAP 與 DAC 的角色
+typedef struct ejCosimSlot {
+   float duty; // 控制器寫入：工作週期
+   float v_i;  // 控制器寫入：V, 輸入電壓
+   float R;    // 控制器寫入：ohm, 負載電阻
+   float v_o;  // 模型寫入：V, 輸出電壓 (DAC_V_O)
+   float i_L;  // 模型寫入：A, 電感電流 (DAC_I_L)
+} ejCosimSlot;
+
+// 放在共享記憶體中的環狀緩衝區，由模型端建立 (並決定 mode)，控制器端連接
+// 控制器填入 tick 的輸入後推進 submitted 並敲 doorbell，模型執行 Cla1Task1 並寫入輸出後推進 completed。
+// 模型在 doorbell 上等待，送出與結束通知都會改變它，因此不會錯過喚醒；控制器在 completed 上等待。
+// 兩組計數器放在不同的快取行。兩個行程共用的欄位只能在 cosim.c 中以 __atomic 內建函式存取，
+// 因此結構本身不使用 _Atomic，C++ 的控制器韌體也能引用此標頭
+typedef struct ejCosimRing {
+   uint32_t magic;                                      // COSIM_MAGIC (最後寫入)
+   uint32_t mode;                                       // COSIM_SPIN 或 COSIM_FUTEX (建立者決定)
+   int32_t plantPid;                                    // 模型行程 (建立者)
+   int32_t ctrlPid;                                     // 控制器行程 (0: 尚未連接，由第一個連接的控制器取得)
+   uint32_t shutdown;                                   // 1: 通知模型結束
+   uint32_t submitted __attribute__((aligned(64)));     // 控制器已送出的 tick 數 (模 2^32)
+   uint32_t doorbell;                                   // 每次送出或結束通知加一，模型的等待字組
+   uint32_t plantWaiting;                               // 模型正在 futex 上休眠
+   uint32_t completed __attribute__((aligned(64)));     // 模型已完成的 tick 數 (模 2^32)，控制器的等待字組
+   uint32_t ctrlWaiting;                                // 控制器正在 futex 上休眠
+   ejCosimSlot slot[COSIM_RING_SLOTS] __attribute__((aligned(64)));
+} ejCosimRing;
+
+//
+// Function Prototypes
+//
+// 模型端
+ejCosimRing* ejCosimCreate(const char*, int); // 建立共享記憶體並指定交接方式
+int ejCosimServe(ejCosimRing*);               // 逐 tick 執行 Cla1Task1，收到結束通知回傳 0，控制器行程消失回傳 -1
+void ejCosimUnlink(const char*);              // 刪除共享記憶體名稱
+
+// 控制器端
+ejCosimRing* ejCosimAttach(const char*);                       // 連接模型建立的共享記憶體，尚未建立完成回傳 0，
+                                                               // 已有其他控制器連接時回傳 0 並設定 errno 為 EBUSY
+int ejCosimSubmit(ejCosimRing*, const ejCosimSlot*, uint32_t); // 送出 n 個 tick 的輸入，空間不足回傳 -1
+int ejCosimWait(ejCosimRing*, ejCosimSlot*, uint32_t, double); // 等待全部完成並取回最後 n 個 tick 的輸出 (n 不可超過已送出的 tick 數)，
+                                                               // n 超過 COSIM_RING_SLOTS、模型行程消失或超過 timeout 秒沒有進度回傳 -1 (timeout <= 0 不限時)
+void ejCosimShutdown(ejCosimRing*);                            // 通知模型結束
+
+// 兩端
+void ejCosimDetach(ejCosimRing*);             // 解除映射
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COSIM_H
+
+//
+// End of file
+//
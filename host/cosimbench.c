@@ -0,0 +1,169 @@
+//
+// Included Files
+//
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "hostsim.h"
+#include "cosim.h"
+
+//
+// Defines
+//
+#define MAX_TICKS    1000000 // 每種設定最多的 tick 數
+#define MIN_ROUNDS   20000   // 每種設定最多的交接次數 (batch 為 1 時)
+#define MAX_BATCH    1000    // 每次交接最多的 tick 數
+#define TIMEOUT      1.0     // s, 模型沒有進度時放棄等待
+#define ATTACH_TRIES 1000    // 等待模型建立共享記憶體的次數 (每次 1 ms)
+
+//
+// Globals
+//
+static const uint32_t batches[] = { 1, 10, 100, MAX_BATCH }; // 每次交接的 tick 數
+
+//
+// Function Prototypes
+//
+static int cmpDouble(const void*, const void*);
+static int runBatch(ejCosimRing*, uint32_t, const char*);
+static void tickInput(long, long, ejCosimSlot*);
+
+//
+// Main
+//
+// 在另一個行程中執行 Buck 模型，量測控制器與模型鎖步交接的延遲與吞吐量
+// 模型行程建立共享記憶體 (與 cosimplant 相同)，本行程以控制器身分連接。
+// Cla1Task1 的工作週期解析度為 1/sample (預設 0.2)，因此控制器送出固定工作週期
+// 與中途的負載步階，並以本行程內直接執行 Cla1Task1 的結果逐位元檢查輸出
+//
+int main(void)
+{
+    const ejHostScenario* sc = &ejHostScenarios[0];
+    int modes[] = { COSIM_SPIN, COSIM_FUTEX };
+    struct timespec ms = { 0, 1000000L };
+    char name[64];
+    int m, b, i, status, ret = 0;
+
+    printf("%-6s %6s %12s %12s %12s %8s\n", "mode", "batch", "ticks/s",
+           "mean us", "p99 us", "outputs");
+
+    for(m = 0; m < 2 && ret == 0; m++){
+        const char* modeName = modes[m] == COSIM_SPIN ? "spin" : "futex";
+        ejCosimRing* r = 0;
+        pid_t pid;
+
+        snprintf(name, sizeof(name), "/ejcosim-%d", (int)getpid());
+        pid = fork();
+        if(pid == 0){
+            // 模型行程：與 cosimplant 相同，建立共享記憶體並服務到結束通知
+            ejCosimRing* plant = ejCosimCreate(name, modes[m]);
+            if(!plant) _exit(1);
+            ejHostInit(&sc->specs, &sc->input);
+            status = ejCosimServe(plant);
+            ejCosimDetach(plant);
+            ejCosimUnlink(name);
+            _exit(status ? 1 : 0);
+        }
+
+        for(i = 0; i < ATTACH_TRIES && !(r = ejCosimAttach(name)); i++) nanosleep(&ms, 0);
+        if(!r){
+            fprintf(stderr, "cannot attach %s\n", name);
+            kill(pid, SIGTERM);
+            waitpid(pid, 0, 0);
+            return 1;
+        }
+
+        // 本行程的模型副本，與模型行程收到相同的輸入序列
+        ejHostInit(&sc->specs, &sc->input);
+        for(b = 0; b < (int)(sizeof(batches) / sizeof(batches[0])) && ret == 0; b++){
+            ret = runBatch(r, batches[b], modeName);
+        }
+
+        ejCosimShutdown(r);
+        waitpid(pid, &status, 0);
+        ejCosimDetach(r);
+        if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) ret = 1;
+    }
+
+    return ret;
+}
+
+// 以每次 batch 個 tick 交接，印出吞吐量與每次交接的來回延遲，
+// 並與本行程的模型副本比較每次交接最後一個 tick 的輸出
+static int runBatch(ejCosimRing* r, uint32_t batch, const char* modeName){
+    long rounds = batch == 1 ? MIN_ROUNDS : MAX_TICKS / batch, i;
+    ejCosimSlot in[MAX_BATCH], out, *last;
+    double *lat, t0, t1, mean = 0;
+    uint32_t k;
+    long mismatch = 0;
+
+    lat = malloc(rounds * sizeof(double));
+    last = malloc(rounds * sizeof(ejCosimSlot));
+    if(!lat || !last){
+        free(lat);
+        free(last);
+        return 1;
+    }
+
+    t0 = ejHostNow();
+    for(i = 0; i < rounds; i++){
+        double tb = ejHostNow();
+
+        for(k = 0; k < batch; k++) tickInput(i, rounds, &in[k]);
+        if(ejCosimSubmit(r, in, batch) != 0){
+            fprintf(stderr, "ring full at round %ld\n", i);
+            break;
+        }
+        if(ejCosimWait(r, &out, 1, TIMEOUT) != 0){
+            fprintf(stderr, "plant not responding at round %ld\n", i);
+            break;
+        }
+        lat[i] = ejHostNow() - tb;
+        last[i] = out;
+    }
+    t1 = ejHostNow();
+
+    // 在量測之外以相同輸入執行本行程的副本並比較
+    if(i == rounds){
+        long j;
+        for(j = 0; j < rounds; j++){
+            for(k = 0; k < batch; k++){
+                tickInput(j, rounds, &in[0]);
+                buckInput.duty = in[0].duty;
+                buckInput.v_i = in[0].v_i;
+                buckSPECS.R = in[0].R;
+                ejHostStep();
+            }
+            if(last[j].v_o != DAC_V_O || last[j].i_L != DAC_I_L) mismatch++;
+        }
+        for(j = 0; j < rounds; j++) mean += lat[j];
+        qsort(lat, rounds, sizeof(double), cmpDouble);
+        printf("%-6s %6u %12.0f %12.2f %12.2f %8s\n", modeName, batch,
+               rounds * batch / (t1 - t0), mean / rounds * 1e6,
+               lat[(long)(rounds * 0.99)] * 1e6, mismatch ? "MISMATCH" : "match");
+    }
+
+    free(lat);
+    free(last);
+    return i < rounds || mismatch ? 1 : 0;
+}
+
+// 第 round 次交接中每個 tick 的輸入：固定工作週期，中途負載步階
+static void tickInput(long round, long rounds, ejCosimSlot* s){
+    s->duty = ejHostScenarios[0].input.duty;
+    s->v_i = ejHostScenarios[0].input.v_i;
+    s->R = round < rounds / 2 ? 5 : 2.5;
+}
+
+static int cmpDouble(const void* a, const void* b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+//
+// End of file
+//
@@ -0,0 +1,47 @@
+//
+// Included Files
+//
+#include <stdio.h>
+#include <string.h>
+#include "hostsim.h"
+#include "cosim.h"
+
+//
+// Main
+//
+// 用法: cosimplant <共享記憶體名稱> [spin|futex]
+// 模型端：建立共享記憶體 (並決定交接方式)，以 Buck 模型服務以 ejCosimAttach 連接的外部控制器，
+// 直到控制器呼叫 ejCosimShutdown 或控制器行程消失
+//
+int main(int argc, char* argv[])
+{
+    const ejHostScenario* sc = &ejHostScenarios[0];
+    int mode = (argc > 2 && strcmp(argv[2], "spin") == 0) ? COSIM_SPIN : COSIM_FUTEX;
+    ejCosimRing* r;
+    int ret;
+
+    if(argc < 2){
+        fprintf(stderr, "usage: %s <name> [spin|futex]\n", argv[0]);
+        return 2;
+    }
+    r = ejCosimCreate(argv[1], mode);
+    if(!r){
+        fprintf(stderr, "cannot create %s\n", argv[1]);
+        return 1;
+    }
+
+    ejHostInit(&sc->specs, &sc->input);
+    printf("serving %s (%s, %s)\n", argv[1], mode == COSIM_SPIN ? "spin" : "futex",
+           HOST_INTEGRATOR);
+    fflush(stdout);
+    ret = ejCosimServe(r);
+    if(ret != 0) fprintf(stderr, "controller exited without shutdown\n");
+
+    ejCosimDetach(r);
+    ejCosimUnlink(argv[1]);
+    return ret ? 1 : 0;
+}
+
+//
+// End of file
+//
@@ -0,0 +1,124 @@
+//
+// Included Files
+//
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "hostsim.h"
+
+//
+// Defines
+//
+#define TIMING_REPEAT 200 // 量測速度時每個情境重複的次數
+
+//
+// Globals
+//
+
+// 每個情境允許的最大誤差 (相對雙精度參考模型)
+// 誤差超過界限即視為回歸，數值約為目前實測值的兩倍
+typedef struct ejErrorBound {
+   const char *name; // 情境名稱
+   double i_L;       // A, 電感電流最大誤差
+   double v_C;       // V, 電容電壓最大誤差
+} ejErrorBound;
+
+#ifdef EULER
+static const ejErrorBound bounds[] = {
+    { "startup",  0.15,   0.25   },
+    { "loadstep", 0.04,   0.05   },
+    { "vinstep",  0.03,   0.03   },
+    { "dcm",      0.2,    0.3    },
+};
+#else
+static const ejErrorBound bounds[] = {
+    { "startup",  7e-3,   8e-3   },
+    { "loadstep", 3e-4,   3e-4   },
+    { "vinstep",  5e-3,   6e-3   },
+    { "dcm",      1e-2,   0.15   },
+};
+#endif
+
+//
+// Function Prototypes
+//
+static const ejErrorBound* findBound(const char*); // 找出情境的誤差界限
+static double runTiming(const ejHostScenario*);    // 量測每秒時間步數
+
+//
+// Main
+//
+int main(void)
+{
+    int s, fail = 0;
+
+    printf("integrator %s, specs %s\n", HOST_INTEGRATOR, HOST_SPECS);
+    printf("%-10s %12s %12s %12s %12s %14s\n", "scenario", "err_i_L",
+           "bound_i_L", "err_v_C", "bound_v_C", "steps/s");
+
+    for(s = 0; s < ejHostScenarioCount; s++){
+        const ejHostScenario* sc = &ejHostScenarios[s];
+        const ejErrorBound* b = findBound(sc->name);
+        ejBuckRefState ref;
+        double errIL = 0, errVC = 0;
+        long k, n;
+        int next = 0, ok;
+
+        ejHostInit(&sc->specs, &sc->input);
+        ejBuckRefInit(&ref);
+        n = ejHostScenarioSteps(sc);
+
+        // 逐步比較 CLA 模型與參考模型
+        for(k = 0; k < n; k++){
+            ejHostApplyEvents(sc, k*(double)dt, &next);
+            ejBuckRefStep(&ref, &buckSPECS, &buckInput, ejHostSwitchOn(), dt);
+            ejHostStep();
+            if((k+1)*(double)dt < sc->tCheck) continue;
+            errIL = fmax(errIL, fabs(buckState_i_L_step - ref.i_L));
+            errVC = fmax(errVC, fabs(buckState_v_C_step - ref.v_C));
+        }
+
+        ok = b && errIL <= b->i_L && errVC <= b->v_C;
+        fail |= !ok;
+        printf("%-10s %12.3e %12.3e %12.3e %12.3e %14.0f%s\n", sc->name,
+               errIL, b ? b->i_L : 0.0, errVC, b ? b->v_C : 0.0,
+               runTiming(sc), ok ? "" : "  REGRESSION");
+    }
+
+    return fail;
+}
+
+// 找出情境的誤差界限
+static const ejErrorBound* findBound(const char* name){
+    int i;
+    for(i = 0; i < (int)(sizeof(bounds) / sizeof(bounds[0])); i++){
+        if(strcmp(bounds[i].name, name) == 0) return &bounds[i];
+    }
+    return 0;
+}
+
+// 只執行 CLA 模型 (不含參考模型)，量測每秒時間步數
+static double runTiming(const ejHostScenario* sc){
+    double t0, t1;
+    long k, n, total = 0;
+    int r, next;
+
+    t0 = ejHostNow();
+    for(r = 0; r < TIMING_REPEAT; r++){
+        ejHostInit(&sc->specs, &sc->input);
+        n = ejHostScenarioSteps(sc);
+        next = 0;
+        for(k = 0; k < n; k++){
+            ejHostApplyEvents(sc, k*(double)dt, &next);
+            ejHostStep();
+        }
+        total += n;
+    }
+    t1 = ejHostNow();
+
+    return total / (t1 - t0);
+}
+
+//
+// End of file
+//
@@ -0,0 +1,176 @@
+//
+// Included Files
+//
+#define _POSIX_C_SOURCE 199309L
+#include <time.h>
+#include "hostsim.h"
+
+//
+// Defines
+//
+#define REF_SUBSTEPS  64 // 參考模型每個時間步的 RK4 子步數
+#define REF_ROOT_ITER 4  // 參考模型定位 i_L 過零點的割線法疊代次數
+
+//
+// Globals
+//
+
+// 取代 main.c 中與 CLA 分享的變數
+ejBuckSPECS buckSPECS; // Buck 電路規格
+ejBuckInput buckInput; // Buck 電路輸入
+float DAC_V_O;         // 來自 CLA 的 DAC 輸出電壓
+float DAC_I_L;         // 來自 CLA 的 DAC 電感電流
+
+// 標準情境，規格與 ejBuckInitSetupCPU 相同
+const ejHostScenario ejHostScenarios[] = {
+    // 啟動：從零狀態開始到穩態
+    { "startup",  {100e-6, 100e-6, 10e-3, 1e-3, 5, 100e3}, {24, 0.208}, 10e-3, 0,
+      0, {{0, 5, 24, 0.208}} },
+    // 負載步階：5 ohm -> 2.5 ohm
+    { "loadstep", {100e-6, 100e-6, 10e-3, 1e-3, 5, 100e3}, {24, 0.208}, 10e-3, 5e-3,
+      1, {{5e-3, 2.5, 24, 0.208}} },
+    // 輸入電壓步階：24 V -> 12 V
+    { "vinstep",  {100e-6, 100e-6, 10e-3, 1e-3, 5, 100e3}, {24, 0.208}, 10e-3, 5e-3,
+      1, {{5e-3, 5, 12, 0.208}} },
+    // 輕載進入不連續導通模式 (DCM)
+    { "dcm",      {100e-6, 100e-6, 10e-3, 1e-3, 50, 100e3}, {24, 0.208}, 20e-3, 0,
+      0, {{0, 50, 24, 0.208}} },
+};
+const int ejHostScenarioCount = sizeof(ejHostScenarios) / sizeof(ejHostScenarios[0]);
+
+//
+// Function Definitions
+//
+
+// 設定規格與輸入，並以 Cla1Task8 初始化 CLA 端的狀態
+void ejHostInit(const ejBuckSPECS* specs, const ejBuckInput* input){
+    buckSPECS = *specs;
+    buckInput = *input;
+#ifdef FIXEDSPECS
+    // 固定規格模式：參考模型必須使用與 CLA 相同的規格
+    buckSPECS.L = FIXED_L;
+    buckSPECS.C = FIXED_C;
+    buckSPECS.r_L = FIXED_r_L;
+    buckSPECS.r_C = FIXED_r_C;
+    buckSPECS.f = FIXED_f;
+#endif
+    Cla1Task8();
+}
+
+// 執行一次 Buck 模型計算，等同 adca1_isr 中的 Cla1ForceTask1andWait
+void ejHostStep(void){
+    Cla1Task1();
+}
+
+// 每個切換週期的取樣點數 (cla.c 中的 sample)
+int ejHostSample(void){
+    return (int)(1.0 / (buckSPECS.f * dt) + 0.5);
+}
+
+// 目前時間步的開關狀態，判斷方式與 Cla1Task1 相同
+int ejHostSwitchOn(void){
+    return prdCTR < (int)(buckInput.duty*ejHostSample());
+}
+
+// 目前工作週期在 Cla1Task1 中實際的導通比例 (以取樣點數量化)
+double ejHostOnFraction(void){
+    int sample = ejHostSample();
+    return (double)(int)(buckInput.duty*sample) / sample;
+}
+
+// 情境所需的時間步數 (須在 ejHostInit 之後呼叫，dt 才會是此情境的步長)
+long ejHostScenarioSteps(const ejHostScenario* sc){
+    return (long)(sc->tEnd / dt + 0.5);
+}
+
+// 套用到時間 t 為止的條件變更，next 為下一個尚未套用的變更
+void ejHostApplyEvents(const ejHostScenario* sc, double t, int* next){
+    while(*next < sc->nEvents && sc->events[*next].t <= t){
+        buckSPECS.R = sc->events[*next].R;
+        buckInput.v_i = sc->events[*next].v_i;
+        buckInput.duty = sc->events[*next].duty;
+        (*next)++;
+    }
+}
+
+// 參考模型狀態歸零
+void ejBuckRefInit(ejBuckRefState* x){
+    x->i_L = 0.0;
+    x->v_C = 0.0;
+}
+
+// 參考模型的狀態方程式，clamp 為 1 時 i_L 降到零後保持為零 (DCM)
+// 參考模型與可變步長積分器 (clamp 為 0，DCM 另行處理) 共用
+void ejBuckRefDeriv(const ejBuckRefState* x, const ejBuckSPECS* s,
+                    double v_i, int clamp, ejBuckRefState* dx){
+    double R = s->R, r_C = s->r_C;
+    double rC_p_R = r_C*R/(r_C+R);
+    double rC_s_R = r_C+R;
+
+    dx->i_L = (- (s->r_L + rC_p_R)*x->i_L - (R / rC_s_R)*x->v_C + v_i) / s->L;
+    dx->v_C = ((R / rC_s_R)*x->i_L - (1.0 / rC_s_R)*x->v_C) / s->C;
+    if(clamp && x->i_L <= 0.0 && dx->i_L < 0.0) dx->i_L = 0.0;
+}
+
+// 單一 RK4 步
+// i_L 為正的子步不箝位：各階段若箝位，過零點附近的 i_L 會以錯誤的斜率下降，
+// 造成與子步長成正比的誤差；過零點改由 ejBuckRefStepN 定位
+static void refRK4(const ejBuckRefState* x, const ejBuckSPECS* s, double v_i,
+                   double h, ejBuckRefState* xNew){
+    ejBuckRefState k1, k2, k3, k4, y;
+    int clamp = x->i_L <= 0.0;
+
+    ejBuckRefDeriv(x, s, v_i, clamp, &k1);
+    y.i_L = x->i_L + 0.5*h*k1.i_L; y.v_C = x->v_C + 0.5*h*k1.v_C;
+    ejBuckRefDeriv(&y, s, v_i, clamp, &k2);
+    y.i_L = x->i_L + 0.5*h*k2.i_L; y.v_C = x->v_C + 0.5*h*k2.v_C;
+    ejBuckRefDeriv(&y, s, v_i, clamp, &k3);
+    y.i_L = x->i_L + h*k3.i_L;     y.v_C = x->v_C + h*k3.v_C;
+    ejBuckRefDeriv(&y, s, v_i, clamp, &k4);
+    xNew->i_L = x->i_L + h/6.0*(k1.i_L + 2.0*k2.i_L + 2.0*k3.i_L + k4.i_L);
+    xNew->v_C = x->v_C + h/6.0*(k1.v_C + 2.0*k2.v_C + 2.0*k3.v_C + k4.v_C);
+}
+
+// 以雙精度 RK4 與細分子步前進一個時間步 h，開關狀態在時間步內固定
+void ejBuckRefStep(ejBuckRefState* x, const ejBuckSPECS* s,
+                   const ejBuckInput* in, int on, double h){
+    ejBuckRefStepN(x, s, in, on, h, REF_SUBSTEPS);
+}
+
+// 同 ejBuckRefStep，以 substeps 個 RK4 子步前進
+// 子步中 i_L 穿越零點時，以割線法找出過零時間並把子步拆成兩段
+void ejBuckRefStepN(ejBuckRefState* x, const ejBuckSPECS* s,
+                    const ejBuckInput* in, int on, double h, int substeps){
+    double v_i = on ? in->v_i : 0.0;
+    double hs = h / substeps;
+    ejBuckRefState y, z;
+    int n, m;
+
+    for(n = 0; n < substeps; n++){
+        refRK4(x, s, v_i, hs, &y);
+        if(x->i_L > 0.0 && y.i_L < 0.0){
+            double hLo = 0.0, iLo = x->i_L, hHi = hs, iHi = y.i_L, hz = hs;
+            for(m = 0; m < REF_ROOT_ITER; m++){
+                hz = hLo + (hHi - hLo) * iLo / (iLo - iHi);
+                refRK4(x, s, v_i, hz, &z);
+                if(z.i_L > 0.0) { hLo = hz; iLo = z.i_L; }
+                else { hHi = hz; iHi = z.i_L; }
+            }
+            z.i_L = 0.0;
+            refRK4(&z, s, v_i, hs - hz, &y);
+        }
+        if(y.i_L < 0.0) y.i_L = 0.0;
+        *x = y;
+    }
+}
+
+// 單調時鐘 (秒)
+double ejHostNow(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//
+// End of file
+//
@@ -0,0 +1,109 @@
+//
+// Included Files
+//
+#ifndef HOSTSIM_H
+#define HOSTSIM_H
+
+#include "../shared.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Defines
+//
+#define HOST_MAX_EVENTS 4 // 每個情境最多的條件變更次數
+
+// 編譯參數所選的 CLA 核心，供報表顯示
+#if defined(EULER)
+#define HOST_INTEGRATOR "EULER"
+#elif defined(IMPROVEDEULER)
+#define HOST_INTEGRATOR "IMPROVEDEULER"
+#else
+#error "請以 -DEULER 或 -DIMPROVEDEULER 編譯"
+#endif
+
+#ifdef FIXEDSPECS
+#define HOST_SPECS "fixed"
+#else
+#define HOST_SPECS "runtime"
+#endif
+
+//
+// Globals
+//
+
+// 由主機端取代 main.c 提供給 CLA 的共享變數
+extern ejBuckSPECS buckSPECS; // Buck 電路規格
+extern ejBuckInput buckInput; // Buck 電路輸入
+extern float DAC_V_O;         // 來自 CLA 的 DAC 輸出電壓
+extern float DAC_I_L;         // 來自 CLA 的 DAC 電感電流
+
+// cla.c 內部的狀態變數 (主機端直接讀取)
+extern float buckState_i_L_step; // A, 目前的電感電流
+extern float buckState_v_C_step; // V, 目前的電容電壓
+extern float buckOutput_v_L;     // V, 電感電壓
+extern float buckOutput_i_C;     // A, 電容電流
+extern float buckOutput_v_o;     // V, 輸出電壓
+extern float prdCTR;             // 切換週期計數器
+extern float dt;                 // 時間步長
+
+// 情境中的條件變更 (負載、輸入電壓或工作週期)
+typedef struct ejHostEvent {
+   double t;   // s, 變更時間
+   float R;    // ohm, 新的負載電阻
+   float v_i;  // V, 新的輸入電壓
+   float duty; // 新的工作週期
+} ejHostEvent;
+
+// 主機端模擬情境
+typedef struct ejHostScenario {
+   const char *name;                    // 情境名稱
+   ejBuckSPECS specs;                   // 初始規格
+   ejBuckInput input;                   // 初始輸入
+   double tEnd;                         // s, 模擬長度
+   double tCheck;                       // s, 從此時間開始比較誤差
+   int nEvents;                         // 條件變更次數
+   ejHostEvent events[HOST_MAX_EVENTS]; // 條件變更 (依時間排序)
+} ejHostScenario;
+
+// 雙精度參考模型的狀態
+typedef struct ejBuckRefState {
+   double i_L; // A, 電感電流
+   double v_C; // V, 電容電壓
+} ejBuckRefState;
+
+extern const ejHostScenario ejHostScenarios[]; // 標準情境
+extern const int ejHostScenarioCount;          // 標準情境數量
+
+//
+// Function Prototypes
+//
+void ejHostInit(const ejBuckSPECS*, const ejBuckInput*); // 設定規格與輸入並執行 Cla1Task8
+void ejHostStep(void);                                   // 執行一次 Cla1Task1
+int ejHostSample(void);                                  // 每個切換週期的取樣點數 (cla.c 中的 sample)
+int ejHostSwitchOn(void);                                // 目前時間步的開關狀態 (與 Cla1Task1 相同判斷)
+double ejHostOnFraction(void);                           // 目前工作週期實際的導通比例
+long ejHostScenarioSteps(const ejHostScenario*);         // 情境所需的時間步數
+void ejHostApplyEvents(const ejHostScenario*, double, int*); // 套用到時間 t 為止的條件變更
+
+void ejBuckRefInit(ejBuckRefState*);                     // 參考模型狀態歸零
+void ejBuckRefDeriv(const ejBuckRefState*, const ejBuckSPECS*,
+                    double, int, ejBuckRefState*);       // 參考模型的狀態方程式 (可選擇是否箝位 i_L)
+void ejBuckRefStep(ejBuckRefState*, const ejBuckSPECS*,
+                   const ejBuckInput*, int, double);     // 參考模型前進一個時間步
+void ejBuckRefStepN(ejBuckRefState*, const ejBuckSPECS*,
+                    const ejBuckInput*, int, double, int); // 同上，指定 RK4 子步數
+
+double ejHostNow(void);                                  // s, 單調時鐘
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_H
+
+//
+// End of file
+//
@@ -0,0 +1,135 @@
+//
+// Included Files
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "hostsim.h"
+#include "multifid.h"
+
+//
+// Defines
+//
+#define PROFILE_END   30.0   // s, 模擬長度
+#define SEGMENT       0.5    // s, 每段輸入條件持續時間
+#define AVG_PERIODS   50     // 平均模型每步的週期數
+#define HOLD_PERIODS  100    // 輸入變更後使用切換模型的週期數
+#define N_PROFILE     10     // 每條負載曲線的段數
+
+//
+// Globals
+//
+// 長時間負載曲線，依序循環
+// mixed 包含一段輕載 DCM (50 ohm)，該段穩態使用 DCM 降階模型；ccm 以 4 ohm 取代該段
+static const float mixedR[N_PROFILE] = { 5,  2.5, 10, 4,  5,  8,  3,  50, 6,  5  };
+static const float ccmR[N_PROFILE]   = { 5,  2.5, 10, 4,  5,  8,  3,  4,  6,  5  };
+static const float profileV_i[N_PROFILE] = { 24, 24,  20, 28, 12, 24, 18, 24, 30, 24 };
+
+//
+// Function Prototypes
+//
+static int compare(const char*, const float*);  // 以一條負載曲線比較兩種方法
+
+//
+// Main
+//
+// 比較完整切換模型與多精度引擎在長時間負載曲線下的週期平均誤差與速度
+// 分別執行包含 DCM 段與只有 CCM 的兩條曲線
+//
+int main(void)
+{
+    printf("profile %.0f s, inputs change every %.1f s, %s kernel\n",
+           PROFILE_END, SEGMENT, HOST_INTEGRATOR);
+    if(compare("mixed (one DCM segment)", mixedR) != 0) return 1;
+    if(compare("CCM only", ccmR) != 0) return 1;
+    return 0;
+}
+
+// 以負載曲線 profileR 與 profileV_i 分別執行完整切換模型與多精度引擎並印出結果
+static int compare(const char* label, const float* profileR){
+    const ejHostScenario* sc = &ejHostScenarios[0];
+    float *fullIL, *fullVC;
+    double t0, t1, tFull, tMF, T;
+    double errAvgIL = 0, errAvgVC = 0, errDcmIL = 0, errDcmVC = 0, errSwIL = 0, errSwVC = 0;
+    long p, nPeriods, segPeriods, adv;
+    int sample, j;
+    ejMultiFid mf;
+
+    ejHostInit(&sc->specs, &sc->input);
+    T = 1.0 / buckSPECS.f;
+    sample = ejHostSample();
+    nPeriods = (long)(PROFILE_END / T + 0.5);
+    segPeriods = (long)(SEGMENT / T + 0.5);
+    fullIL = malloc(nPeriods * sizeof(float));
+    fullVC = malloc(nPeriods * sizeof(float));
+    if(!fullIL || !fullVC){
+        free(fullIL);
+        free(fullVC);
+        return -1;
+    }
+
+    // 完整切換模型，記錄每個週期的梯形平均
+    t0 = ejHostNow();
+    for(p = 0; p < nPeriods; p++){
+        double sumI = 0.5*buckState_i_L_step, sumV = 0.5*buckState_v_C_step;
+        buckSPECS.R = profileR[(p / segPeriods) % N_PROFILE];
+        buckInput.v_i = profileV_i[(p / segPeriods) % N_PROFILE];
+        for(j = 1; j <= sample; j++){
+            ejHostStep();
+            sumI += (j < sample ? 1.0 : 0.5) * buckState_i_L_step;
+            sumV += (j < sample ? 1.0 : 0.5) * buckState_v_C_step;
+        }
+        fullIL[p] = sumI / sample;
+        fullVC[p] = sumV / sample;
+    }
+    t1 = ejHostNow();
+    tFull = t1 - t0;
+
+    // 多精度引擎，在每個比較點與完整模型的同一週期平均比較
+    ejHostInit(&sc->specs, &sc->input);
+    buckSPECS.R = profileR[0];
+    buckInput.v_i = profileV_i[0];
+    if(ejMultiFidInit(&mf, AVG_PERIODS, HOLD_PERIODS) != 0){
+        free(fullIL);
+        free(fullVC);
+        return -1;
+    }
+    t0 = ejHostNow();
+    for(p = 0; p < nPeriods; p += adv){
+        long seg = p / segPeriods;
+        buckSPECS.R = profileR[seg % N_PROFILE];
+        buckInput.v_i = profileV_i[seg % N_PROFILE];
+        adv = ejMultiFidAdvance(&mf, (seg + 1)*segPeriods - p);
+        if(mf.switched){
+            errSwIL = fmax(errSwIL, fabs(mf.avg.i_L - fullIL[p + adv - 1]));
+            errSwVC = fmax(errSwVC, fabs(mf.avg.v_C - fullVC[p + adv - 1]));
+        }
+        else if(mf.dcm){
+            errDcmIL = fmax(errDcmIL, fabs(mf.avg.i_L - fullIL[p + adv - 1]));
+            errDcmVC = fmax(errDcmVC, fabs(mf.avg.v_C - fullVC[p + adv - 1]));
+        }
+        else{
+            errAvgIL = fmax(errAvgIL, fabs(mf.avg.i_L - fullIL[p + adv - 1]));
+            errAvgVC = fmax(errAvgVC, fabs(mf.avg.v_C - fullVC[p + adv - 1]));
+        }
+    }
+    t1 = ejHostNow();
+    tMF = t1 - t0;
+
+    printf("\n%s: %ld periods\n", label, nPeriods);
+    printf("full switched : %10ld steps, %9.1f ms\n", nPeriods*sample, tFull*1e3);
+    printf("multi-fidelity: %10ld switched steps + %ld averaged steps (%ld DCM), %ld handoffs, "
+           "%9.1f ms, speedup %.1fx\n", mf.nSwitchedSteps, mf.nAvgSteps, mf.nDcmSteps,
+           mf.nHandoffs, tMF*1e3, tFull / tMF);
+    printf("cycle-average error vs full run: CCM averaged i_L %.3e A, v_C %.3e V; "
+           "DCM averaged i_L %.3e A, v_C %.3e V; switched i_L %.3e A, v_C %.3e V\n",
+           errAvgIL, errAvgVC, errDcmIL, errDcmVC, errSwIL, errSwVC);
+
+    free(fullIL);
+    free(fullVC);
+    return 0;
+}
+
+//
+// End of file
+//
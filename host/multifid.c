@@ -0,0 +1,253 @@
+//
+// Included Files
+//
+#include <math.h>
+#include <string.h>
+#include "multifid.h"
+
+//
+// Defines
+//
+#define DCM_ENTER   0.6 // 週期平均 i_L 低於此倍數的漣波峰對峰值時視為接近 DCM
+#define DCM_LEAVE   0.7 // 回到 CCM 平均模型的門檻 (留有遲滯，避免反覆交接)
+#define DCM_AVG_ENTER 0.4  // 週期平均 i_L 低於此倍數的峰值電流時改用 DCM 降階模型 (DCM 時此比值 < 0.5)
+#define DCM_AVG_LEAVE 0.45 // 離開 DCM 降階模型的門檻
+#define DCM_SUBSTEPS  4    // DCM 降階模型每步的 RK4 子步數
+#define EXPM_TERMS  16  // 矩陣指數 Taylor 展開項數
+
+//
+// Function Prototypes
+//
+static void expm3(double[3][3], double[3][3]);       // 3x3 矩陣指數
+static void discretize(double, double[2][2], double*); // 平均模型離散化
+static double rippleAmplitude(const ejMultiFid*);     // A, 電感電流漣波峰對峰值
+static double dcmCurrent(double);                     // A, DCM 的週期平均 i_L
+static void dcmStep(ejMultiFid*, double);             // DCM 降階模型前進指定時間
+static void toSwitched(ejMultiFid*);                  // 平均模型 -> 切換模型
+static void switchedPeriod(ejMultiFid*);              // 切換模型前進一個週期
+
+//
+// Function Definitions
+//
+
+// 以目前的 buckSPECS/buckInput 初始化，狀態與 Cla1Task8 一樣從零開始
+// avgPeriods 須至少為 1 (否則平均模型每步前進 0 個週期)，holdPeriods 不可為負，不符時回傳 -1
+int ejMultiFidInit(ejMultiFid* mf, int avgPeriods, int holdPeriods){
+    memset(mf, 0, sizeof(*mf));
+    if(avgPeriods < 1 || holdPeriods < 0) return -1;
+    mf->avgPeriods = avgPeriods;
+    mf->holdPeriods = holdPeriods;
+    mf->R = buckSPECS.R;
+    mf->v_i = buckInput.v_i;
+    mf->duty = buckInput.duty;
+    // 啟動本身就是暫態
+    mf->holdUntil = holdPeriods;
+    return 0;
+}
+
+// 以目前的輸入前進最多 maxPeriods 個週期，回傳實際前進的週期數
+// 切換模型每次前進一個週期，平均模型每次前進 avgPeriods 個週期 (不足時前進一個週期)
+long ejMultiFidAdvance(ejMultiFid* mf, long maxPeriods){
+    double ripple;
+    int want, wantDcm = 0;
+
+    // 輸入變更：重新離散化，並在接下來的 holdPeriods 個週期使用切換模型
+    if(buckSPECS.R != mf->R || buckInput.v_i != mf->v_i || buckInput.duty != mf->duty){
+        // 交接須以變更前的輸入重建漣波
+        if(!mf->switched){
+            toSwitched(mf);
+            mf->switched = 1;
+            mf->nHandoffs++;
+        }
+        mf->R = buckSPECS.R;
+        mf->v_i = buckInput.v_i;
+        mf->duty = buckInput.duty;
+        mf->holdUntil = mf->period + mf->holdPeriods;
+        mf->valid = 0;
+        mf->dcm = 0;
+    }
+
+    // 穩態時依週期平均 i_L 與峰值電流的比值選擇 CCM 或 DCM 平均模型，兩者之間的區間使用切換模型
+    ripple = rippleAmplitude(mf);
+    want = mf->ripple || mf->period < mf->holdUntil;
+    if(!want){
+        if(ripple <= 0 || mf->avg.i_L < (mf->dcm ? DCM_AVG_LEAVE : DCM_AVG_ENTER) * ripple){
+            wantDcm = 1;
+        }
+        else{
+            want = mf->avg.i_L < (mf->switched || mf->dcm ? DCM_LEAVE : DCM_ENTER) * ripple;
+        }
+    }
+    if(want != mf->switched || (!want && wantDcm != mf->dcm)){
+        if(want) toSwitched(mf);
+        mf->switched = want;
+        mf->dcm = wantDcm;
+        mf->nHandoffs++;
+    }
+
+    if(mf->switched){
+        switchedPeriod(mf);
+        mf->period++;
+        return 1;
+    }
+    if(mf->dcm){
+        long n = maxPeriods >= mf->avgPeriods ? mf->avgPeriods : 1;
+        dcmStep(mf, n / buckSPECS.f);
+        mf->nAvgSteps++;
+        mf->nDcmSteps++;
+        mf->period += n;
+        return n;
+    }
+
+    if(!mf->valid){
+        discretize(mf->avgPeriods / buckSPECS.f, mf->phi, mf->gam);
+        mf->valid = 1;
+    }
+    if(maxPeriods >= mf->avgPeriods){
+        ejBuckRefState x = mf->avg;
+        mf->avg.i_L = mf->phi[0][0]*x.i_L + mf->phi[0][1]*x.v_C + mf->gam[0];
+        mf->avg.v_C = mf->phi[1][0]*x.i_L + mf->phi[1][1]*x.v_C + mf->gam[1];
+        mf->nAvgSteps++;
+        mf->period += mf->avgPeriods;
+        return mf->avgPeriods;
+    }
+    else{
+        // 剩餘週期不足一個平均步 (例如下一個輸入變更之前)，逐週期前進
+        double phi[2][2], gam[2];
+        ejBuckRefState x = mf->avg;
+        discretize(1.0 / buckSPECS.f, phi, gam);
+        mf->avg.i_L = phi[0][0]*x.i_L + phi[0][1]*x.v_C + gam[0];
+        mf->avg.v_C = phi[1][0]*x.i_L + phi[1][1]*x.v_C + gam[1];
+        mf->nAvgSteps++;
+        mf->period++;
+        return 1;
+    }
+}
+
+// 平均模型 dx/dt = A x + b 在時間 H 的精確離散化：x(H) = phi x(0) + gam
+// 以擴增矩陣 [[A H, b H], [0, 0]] 的矩陣指數同時求出 phi 與 gam
+static void discretize(double H, double phi[2][2], double* gam){
+    double R = buckSPECS.R, r_C = buckSPECS.r_C;
+    double rC_p_R = r_C*R/(r_C+R);
+    double rC_s_R = r_C+R;
+    double M[3][3] = {{0}}, E[3][3];
+
+    M[0][0] = - (buckSPECS.r_L + rC_p_R) / buckSPECS.L * H;
+    M[0][1] = - (R / rC_s_R) / buckSPECS.L * H;
+    M[0][2] = ejHostOnFraction() * buckInput.v_i / buckSPECS.L * H;
+    M[1][0] = (R / rC_s_R) / buckSPECS.C * H;
+    M[1][1] = - (1.0 / rC_s_R) / buckSPECS.C * H;
+    expm3(M, E);
+
+    phi[0][0] = E[0][0]; phi[0][1] = E[0][1];
+    phi[1][0] = E[1][0]; phi[1][1] = E[1][1];
+    gam[0] = E[0][2];
+    gam[1] = E[1][2];
+}
+
+// 3x3 矩陣指數 (縮放與平方法 + Taylor 展開)
+static void expm3(double M[3][3], double E[3][3]){
+    double A[3][3], term[3][3], tmp[3][3], norm = 0;
+    int i, j, k, n, s = 0;
+
+    for(i = 0; i < 3; i++){
+        double row = 0;
+        for(j = 0; j < 3; j++) row += fabs(M[i][j]);
+        if(row > norm) norm = row;
+    }
+    while(norm > 0.5){ norm /= 2; s++; }
+
+    for(i = 0; i < 3; i++){
+        for(j = 0; j < 3; j++){
+            A[i][j] = ldexp(M[i][j], -s);
+            E[i][j] = term[i][j] = (i == j);
+        }
+    }
+    for(n = 1; n <= EXPM_TERMS; n++){
+        for(i = 0; i < 3; i++){
+            for(j = 0; j < 3; j++){
+                tmp[i][j] = 0;
+                for(k = 0; k < 3; k++) tmp[i][j] += term[i][k]*A[k][j];
+            }
+        }
+        for(i = 0; i < 3; i++){
+            for(j = 0; j < 3; j++){
+                term[i][j] = tmp[i][j] / n;
+                E[i][j] += term[i][j];
+            }
+        }
+    }
+    while(s-- > 0){
+        for(i = 0; i < 3; i++){
+            for(j = 0; j < 3; j++){
+                tmp[i][j] = 0;
+                for(k = 0; k < 3; k++) tmp[i][j] += E[i][k]*E[k][j];
+            }
+        }
+        memcpy(E, tmp, sizeof(tmp));
+    }
+}
+
+// 電感電流漣波峰對峰值 (導通期間的電流上升量)，使用目前平均狀態所對應的輸入
+static double rippleAmplitude(const ejMultiFid* mf){
+    int sample = ejHostSample();
+    double D = (double)(int)(mf->duty*sample) / sample;
+    return (mf->v_i - mf->avg.v_C) * D / buckSPECS.f / buckSPECS.L;
+}
+
+// DCM 的週期平均 i_L (忽略 r_L、r_C 對電感電壓的影響)
+// 導通期間 D T 上升到峰值 (v_i - v_C) D T / L，關斷後以 v_C / L 下降，
+// 下降時間 d2 T = D T (v_i - v_C) / v_C，之後 i_L 維持為零，平均值為峰值 (D + d2) / 2
+static double dcmCurrent(double v_C){
+    double D = ejHostOnFraction(), v_i = buckInput.v_i;
+    double peak = (v_i - v_C) * D / buckSPECS.f / buckSPECS.L;
+
+    if(v_C <= 0 || peak <= 0) return 0;
+    return peak * D * v_i / (2.0 * v_C);
+}
+
+// DCM 降階模型：i_L 以週期平均值代入電容方程式，只剩 v_C 一個狀態，以 RK4 前進時間 H
+static void dcmStep(ejMultiFid* mf, double H){
+    double R = buckSPECS.R, rC_s_R = buckSPECS.r_C + R, C = buckSPECS.C;
+    double h = H / DCM_SUBSTEPS, v = mf->avg.v_C, k1, k2, k3, k4;
+    int n;
+
+    for(n = 0; n < DCM_SUBSTEPS; n++){
+        k1 = ((R / rC_s_R)*dcmCurrent(v)            - v / rC_s_R) / C;
+        k2 = ((R / rC_s_R)*dcmCurrent(v + 0.5*h*k1) - (v + 0.5*h*k1) / rC_s_R) / C;
+        k3 = ((R / rC_s_R)*dcmCurrent(v + 0.5*h*k2) - (v + 0.5*h*k2) / rC_s_R) / C;
+        k4 = ((R / rC_s_R)*dcmCurrent(v + h*k3)     - (v + h*k3) / rC_s_R) / C;
+        v += h/6.0*(k1 + 2.0*k2 + 2.0*k3 + k4);
+    }
+    mf->avg.v_C = v;
+    mf->avg.i_L = dcmCurrent(v);
+}
+
+// 平均模型 -> 切換模型：週期起點的 i_L 位於漣波谷底 (DCM 時為零)，v_C 的漣波忽略不計
+static void toSwitched(ejMultiFid* mf){
+    float i_L = mf->avg.i_L - 0.5*rippleAmplitude(mf);
+
+    buckState_i_L_step = i_L > 0 ? i_L : 0;
+    buckState_v_C_step = mf->avg.v_C;
+    prdCTR = 0;
+}
+
+// 切換模型前進一個週期，並以梯形法求出此週期的平均狀態 (供交接回平均模型)
+static void switchedPeriod(ejMultiFid* mf){
+    int sample = ejHostSample(), j;
+    double sumI = 0.5*buckState_i_L_step;
+    double sumV = 0.5*buckState_v_C_step;
+
+    for(j = 1; j <= sample; j++){
+        ejHostStep();
+        sumI += (j < sample ? 1.0 : 0.5) * buckState_i_L_step;
+        sumV += (j < sample ? 1.0 : 0.5) * buckState_v_C_step;
+    }
+    mf->avg.i_L = sumI / sample;
+    mf->avg.v_C = sumV / sample;
+    mf->nSwitchedSteps += sample;
+}
+
+//
+// End of file
+//
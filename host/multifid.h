@@ -0,0 +1,57 @@
+//
+// Included Files
+//
+#ifndef MULTIFID_H
+#define MULTIFID_H
+
+#include "hostsim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Globals
+//
+
+// 多精度模擬引擎
+// 穩態時以平均模型一次前進多個切換週期：CCM 使用狀態空間平均模型 (精確離散化)，
+// DCM 使用以 v_C 為狀態的降階平均模型 (週期平均 i_L 由 v_C 代數求出)。
+// 輸入變更後的暫態、CCM/DCM 邊界附近或要求漣波細節時改用 Cla1Task1 的切換模型。
+// 各模型之間以週期平均的 i_L/v_C 交接
+typedef struct ejMultiFid {
+   ejBuckRefState avg;  // 最近一個週期起點的週期平均狀態
+   long period;         // 已模擬的切換週期數
+   int switched;        // 1: 目前使用切換模型
+   int dcm;             // 1: 目前使用 DCM 降階平均模型 (switched 為 0 時才有意義)
+   int ripple;          // 1: 要求漣波細節 (由使用者設定，強制使用切換模型)
+   int avgPeriods;      // 平均模型每步前進的週期數
+   int holdPeriods;     // 輸入變更後使用切換模型的週期數
+   long holdUntil;      // 切換模型至少持續到此週期
+   float R;             // ohm, 上一次的負載 (用於偵測輸入變更)
+   float v_i;           // V, 上一次的輸入電壓
+   float duty;          // 上一次的工作週期
+   int valid;           // 1: phi/gam 對應目前的輸入
+   double phi[2][2];    // 平均模型 avgPeriods 個週期的狀態轉移矩陣
+   double gam[2];       // 平均模型 avgPeriods 個週期的輸入響應
+   long nAvgSteps;      // 平均模型步數 (包含 DCM 降階模型)
+   long nDcmSteps;      // DCM 降階平均模型步數
+   long nSwitchedSteps; // 切換模型時間步數 (Cla1Task1 次數)
+   long nHandoffs;      // 模型交接次數
+} ejMultiFid;
+
+//
+// Function Prototypes
+//
+int ejMultiFidInit(ejMultiFid*, int, int);  // 以目前的 buckSPECS/buckInput 初始化 (須先呼叫 ejHostInit)，參數無效時回傳 -1
+long ejMultiFidAdvance(ejMultiFid*, long);  // 以目前的輸入前進最多指定的週期數，回傳實際前進的週期數
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MULTIFID_H
+
+//
+// End of file
+//
@@ -0,0 +1,342 @@
+//
+// Included Files
+//
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "trace.h"
+
+//
+// Function Prototypes
+//
+static uint64_t levelCount(uint64_t, int);                 // 第 l 層的筆數
+static int validHeader(const ejTraceHeader*, size_t);      // 檢查檔頭與檔案大小是否一致
+static int pwriteAll(int, const void*, size_t, uint64_t);  // 寫入完整緩衝區
+
+//
+// Function Definitions
+//
+
+// 建立輸出檔案並寫入暫時的檔頭
+int ejTraceOpenWrite(ejTraceWriter* w, const char* path, const ejBuckSPECS* specs,
+                     const char* integrator, double dt, int nColumns,
+                     const char* const* names, uint32_t chunkRows){
+    static const unsigned char zero[TRACE_DATA_OFFSET];
+    int c;
+
+    memset(w, 0, sizeof(*w));
+    if(nColumns <= 0 || nColumns > TRACE_MAX_COLUMNS) return -1;
+    if(chunkRows == 0) chunkRows = TRACE_CHUNK_ROWS;
+    if(chunkRows % TRACE_FANOUT != 0) return -1;
+
+    memcpy(w->hdr.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    w->hdr.version = TRACE_VERSION;
+    w->hdr.nColumns = nColumns;
+    w->hdr.chunkRows = chunkRows;
+    w->hdr.dt = dt;
+    w->hdr.specs = *specs;
+    strncpy(w->hdr.integrator, integrator, sizeof(w->hdr.integrator) - 1);
+    for(c = 0; c < nColumns; c++){
+        strncpy(w->hdr.names[c], names[c], TRACE_NAME_LEN - 1);
+    }
+    w->hdr.levelOffset[0] = TRACE_DATA_OFFSET;
+
+    w->chunk = malloc((size_t)nColumns * chunkRows * sizeof(float));
+    w->fp = fopen(path, "w+b");
+    if(!w->chunk || !w->fp || fwrite(zero, 1, sizeof(zero), w->fp) != sizeof(zero)){
+        if(w->fp) fclose(w->fp);
+        free(w->chunk);
+        w->fp = 0;
+        w->chunk = 0;
+        return -1;
+    }
+    return 0;
+}
+
+// 附加一列，區塊填滿時整塊寫出
+int ejTraceAppend(ejTraceWriter* w, const float* row){
+    uint32_t n = w->hdr.chunkRows;
+    uint32_t c;
+
+    for(c = 0; c < w->hdr.nColumns; c++){
+        w->chunk[(size_t)c*n + w->fill] = row[c];
+    }
+    w->hdr.nRows++;
+
+    if(++w->fill == n){
+        w->fill = 0;
+        if(fwrite(w->chunk, sizeof(float)*n, w->hdr.nColumns, w->fp) != w->hdr.nColumns){
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// 寫出最後一個區塊 (不足的列補零)，建立最小值/最大值金字塔並更新檔頭
+int ejTraceClose(ejTraceWriter* w){
+    ejTraceHeader* h = &w->hdr;
+    uint64_t nChunks, dataBytes = 0, count, prevCount, e, k;
+    ejTraceMinMax *level = 0, *prev = 0;
+    const unsigned char* map = MAP_FAILED;
+    int fd, l, ret = -1;
+    uint32_t c;
+
+    if(w->fill){
+        for(c = 0; c < h->nColumns; c++){
+            memset(&w->chunk[(size_t)c*h->chunkRows + w->fill], 0,
+                   sizeof(float)*(h->chunkRows - w->fill));
+        }
+        if(fwrite(w->chunk, sizeof(float)*h->chunkRows, h->nColumns, w->fp) != h->nColumns){
+            goto done;
+        }
+    }
+    if(fflush(w->fp) != 0) goto done;
+    fd = fileno(w->fp);
+
+    // 計算金字塔各層位置
+    nChunks = (h->nRows + h->chunkRows - 1) / h->chunkRows;
+    dataBytes = nChunks * h->nColumns * h->chunkRows * sizeof(float);
+    h->levelOffset[1] = TRACE_DATA_OFFSET + dataBytes;
+    for(l = 1; l <= TRACE_MAX_LEVELS && levelCount(h->nRows, l-1) > 1; l++){
+        h->nLevels = l;
+        if(l < TRACE_MAX_LEVELS){
+            h->levelOffset[l+1] = h->levelOffset[l] +
+                    h->nColumns * levelCount(h->nRows, l) * sizeof(ejTraceMinMax);
+        }
+    }
+
+    if(h->nLevels){
+        map = mmap(0, TRACE_DATA_OFFSET + dataBytes, PROT_READ, MAP_SHARED, fd, 0);
+        level = malloc(levelCount(h->nRows, 1) * sizeof(ejTraceMinMax));
+        prev = malloc(levelCount(h->nRows, 1) * sizeof(ejTraceMinMax));
+        if(map == MAP_FAILED || !level || !prev) goto done;
+    }
+
+    for(c = 0; c < h->nColumns; c++){
+        prevCount = h->nRows;
+        for(l = 1; l <= (int)h->nLevels; l++){
+            count = levelCount(h->nRows, l);
+            for(e = 0; e < count; e++){
+                uint64_t k0 = e * TRACE_FANOUT;
+                uint64_t k1 = k0 + TRACE_FANOUT < prevCount ? k0 + TRACE_FANOUT : prevCount;
+                ejTraceMinMax mm;
+
+                if(l == 1){
+                    // 由原始資料建立第一層，同一筆不會跨越區塊
+                    const float* v = (const float*)(map + TRACE_DATA_OFFSET) +
+                            ((k0 / h->chunkRows) * h->nColumns + c) * h->chunkRows +
+                            k0 % h->chunkRows;
+                    mm.min = mm.max = v[0];
+                    for(k = 1; k < k1 - k0; k++){
+                        if(v[k] < mm.min) mm.min = v[k];
+                        if(v[k] > mm.max) mm.max = v[k];
+                    }
+                }
+                else{
+                    // 由上一層建立
+                    mm = prev[k0];
+                    for(k = k0 + 1; k < k1; k++){
+                        if(prev[k].min < mm.min) mm.min = prev[k].min;
+                        if(prev[k].max > mm.max) mm.max = prev[k].max;
+                    }
+                }
+                level[e] = mm;
+            }
+            if(pwriteAll(fd, level, count * sizeof(ejTraceMinMax),
+                         h->levelOffset[l] + c * count * sizeof(ejTraceMinMax)) != 0){
+                goto done;
+            }
+            // 交換緩衝區，本層成為下一層的輸入
+            { ejTraceMinMax* t = prev; prev = level; level = t; }
+            prevCount = count;
+        }
+    }
+
+    ret = pwriteAll(fd, h, sizeof(*h), 0);
+
+done:
+    if(map != MAP_FAILED) munmap((void*)map, TRACE_DATA_OFFSET + dataBytes);
+    free(level);
+    free(prev);
+    free(w->chunk);
+    if(fclose(w->fp) != 0) ret = -1;
+    w->chunk = 0;
+    w->fp = 0;
+    return ret;
+}
+
+// 以 mmap 開啟檔案並檢查檔頭
+int ejTraceOpenRead(ejTraceReader* r, const char* path){
+    struct stat st;
+    void* map;
+    int fd;
+
+    memset(r, 0, sizeof(*r));
+    fd = open(path, O_RDONLY);
+    if(fd < 0) return -1;
+    if(fstat(fd, &st) != 0 || st.st_size < TRACE_DATA_OFFSET){
+        close(fd);
+        return -1;
+    }
+    map = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) return -1;
+
+    r->base = map;
+    r->size = st.st_size;
+    r->hdr = map;
+    if(memcmp(r->hdr->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+       r->hdr->version != TRACE_VERSION ||
+       !validHeader(r->hdr, r->size)){
+        ejTraceCloseRead(r);
+        return -1;
+    }
+    return 0;
+}
+
+// 解除映射
+void ejTraceCloseRead(ejTraceReader* r){
+    if(r->base) munmap((void*)r->base, r->size);
+    memset(r, 0, sizeof(*r));
+}
+
+// 依名稱找出欄位，找不到回傳 -1
+int ejTraceFindColumn(const ejTraceReader* r, const char* name){
+    uint32_t c;
+    for(c = 0; c < r->hdr->nColumns; c++){
+        if(strncmp(r->hdr->names[c], name, TRACE_NAME_LEN) == 0) return c;
+    }
+    return -1;
+}
+
+// 取得某欄位在某區塊中的連續資料，count 為有效列數
+const float* ejTraceChunk(const ejTraceReader* r, int col, uint64_t chunk, uint32_t* count){
+    const ejTraceHeader* h = r->hdr;
+    uint64_t row0 = chunk * h->chunkRows;
+
+    if(col < 0 || col >= (int)h->nColumns || row0 >= h->nRows){
+        *count = 0;
+        return 0;
+    }
+    *count = h->nRows - row0 < h->chunkRows ? (uint32_t)(h->nRows - row0) : h->chunkRows;
+    return (const float*)(r->base + TRACE_DATA_OFFSET) +
+            (chunk * h->nColumns + col) * h->chunkRows;
+}
+
+// 取得單一取樣點
+float ejTraceValue(const ejTraceReader* r, int col, uint64_t row){
+    const ejTraceHeader* h = r->hdr;
+    return ((const float*)(r->base + TRACE_DATA_OFFSET))
+            [((row / h->chunkRows) * h->nColumns + col) * h->chunkRows + row % h->chunkRows];
+}
+
+// 取得某欄位第 level 層 (1..nLevels) 的金字塔資料
+const ejTraceMinMax* ejTraceLevel(const ejTraceReader* r, int col, int level, uint64_t* count){
+    const ejTraceHeader* h = r->hdr;
+
+    if(col < 0 || col >= (int)h->nColumns || level < 1 || level > (int)h->nLevels){
+        *count = 0;
+        return 0;
+    }
+    *count = levelCount(h->nRows, level);
+    return (const ejTraceMinMax*)(r->base + h->levelOffset[level]) + col * *count;
+}
+
+// 將 [row0, row1) 分成 bins 個區間並求出各區間的最小值/最大值
+// 使用每筆涵蓋範圍不超過一個區間的最粗層，回傳實際的區間數
+int ejTraceRange(const ejTraceReader* r, int col, uint64_t row0, uint64_t row1,
+                 int bins, ejTraceMinMax* out){
+    const ejTraceHeader* h = r->hdr;
+    const ejTraceMinMax* lv = 0;
+    uint64_t span, scale = 1, count, a, b, k;
+    int l = 0, i;
+
+    if(row1 > h->nRows) row1 = h->nRows;
+    if(col < 0 || col >= (int)h->nColumns || row0 >= row1 || bins <= 0) return 0;
+    span = row1 - row0;
+    if((uint64_t)bins > span) bins = (int)span;
+
+    while(l < (int)h->nLevels && scale * TRACE_FANOUT <= span / bins){
+        scale *= TRACE_FANOUT;
+        l++;
+    }
+    if(l) lv = ejTraceLevel(r, col, l, &count);
+
+    for(i = 0; i < bins; i++){
+        a = row0 + span * i / bins;
+        b = row0 + span * (i + 1) / bins;
+        if(l == 0){
+            out[i].min = out[i].max = ejTraceValue(r, col, a);
+            for(k = a + 1; k < b; k++){
+                float v = ejTraceValue(r, col, k);
+                if(v < out[i].min) out[i].min = v;
+                if(v > out[i].max) out[i].max = v;
+            }
+        }
+        else{
+            uint64_t e1 = (b + scale - 1) / scale;
+            out[i] = lv[a / scale];
+            for(k = a / scale + 1; k < e1 && k < count; k++){
+                if(lv[k].min < out[i].min) out[i].min = lv[k].min;
+                if(lv[k].max > out[i].max) out[i].max = lv[k].max;
+            }
+        }
+    }
+    return bins;
+}
+
+// 第 l 層的筆數
+static uint64_t levelCount(uint64_t nRows, int l){
+    while(l-- > 0) nRows = (nRows + TRACE_FANOUT - 1) / TRACE_FANOUT;
+    return nRows;
+}
+
+// 檢查檔頭與檔案大小是否一致，確保讀取函式不會存取映射區之外
+// 資料區須完整存在，各層金字塔依序排列於資料區之後且不超出檔案
+static int validHeader(const ejTraceHeader* h, size_t size){
+    uint64_t rowBytes, nChunks, end;
+    uint32_t l;
+
+    if(h->nColumns == 0 || h->nColumns > TRACE_MAX_COLUMNS ||
+       h->chunkRows == 0 || h->chunkRows % TRACE_FANOUT != 0 ||
+       h->nLevels > TRACE_MAX_LEVELS){
+        return 0;
+    }
+    // 先以除法檢查區塊數，避免 nRows 過大時乘法溢位
+    rowBytes = (uint64_t)h->nColumns * h->chunkRows * sizeof(float);
+    nChunks = h->nRows / h->chunkRows + (h->nRows % h->chunkRows != 0);
+    if(nChunks > (size - TRACE_DATA_OFFSET) / rowBytes) return 0;
+    end = TRACE_DATA_OFFSET + nChunks * rowBytes;
+
+    for(l = 1; l <= h->nLevels; l++){
+        uint64_t bytes = (uint64_t)h->nColumns * levelCount(h->nRows, l) *
+                         sizeof(ejTraceMinMax);
+        if(h->levelOffset[l] < end || h->levelOffset[l] > size ||
+           bytes > size - h->levelOffset[l]){
+            return 0;
+        }
+        end = h->levelOffset[l] + bytes;
+    }
+    return 1;
+}
+
+// 寫入完整緩衝區
+static int pwriteAll(int fd, const void* buf, size_t len, uint64_t off){
+    const unsigned char* p = buf;
+    while(len){
+        ssize_t n = pwrite(fd, p, len, (off_t)off);
+        if(n <= 0) return -1;
+        p += n;
+        len -= n;
+        off += n;
+    }
+    return 0;
+}
+
+//
+// End of file
+//
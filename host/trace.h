@@ -0,0 +1,98 @@
+//
+// Included Files
+//
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include "../shared.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Defines
+//
+// 檔案格式 (原生位元組順序)：
+//   [0, TRACE_DATA_OFFSET)  ejTraceHeader
+//   資料區                  依序排列的區塊，每個區塊內每個欄位連續存放 chunkRows 個 float
+//   金字塔區                第 l 層 (l = 1..nLevels) 依欄位排列，每筆為 ejTraceMinMax，
+//                           涵蓋 TRACE_FANOUT^l 個取樣點
+//
+#define TRACE_MAGIC         "EJTRACE"
+#define TRACE_VERSION       1
+#define TRACE_MAX_COLUMNS   8      // 最多欄位數
+#define TRACE_NAME_LEN      16     // 欄位名稱長度
+#define TRACE_MAX_LEVELS    16     // 金字塔最多層數
+#define TRACE_FANOUT        64     // 金字塔每層的縮減倍數
+#define TRACE_CHUNK_ROWS    65536  // 預設每個區塊的列數 (須為 TRACE_FANOUT 的倍數)
+#define TRACE_DATA_OFFSET   4096   // 資料區起始位置，對齊記憶體分頁
+
+//
+// Globals
+//
+
+// 檔頭
+typedef struct ejTraceHeader {
+   char magic[8];                                  // TRACE_MAGIC
+   uint32_t version;                               // TRACE_VERSION
+   uint32_t nColumns;                              // 欄位數
+   uint32_t chunkRows;                             // 每個區塊的列數
+   uint32_t nLevels;                               // 金字塔層數 (關閉檔案時寫入)
+   uint64_t nRows;                                 // 總列數 (關閉檔案時寫入)
+   double dt;                                      // s, 每列的時間間隔
+   ejBuckSPECS specs;                              // 模擬開始時的規格
+   char integrator[16];                            // 使用的積分法
+   char names[TRACE_MAX_COLUMNS][TRACE_NAME_LEN];  // 欄位名稱
+   uint64_t levelOffset[TRACE_MAX_LEVELS + 1];     // 第 l 層的起始位置 (第 0 層為原始資料)
+} ejTraceHeader;
+
+// 金字塔中的一筆最小值/最大值
+typedef struct ejTraceMinMax {
+   float min;
+   float max;
+} ejTraceMinMax;
+
+// 串流寫入器
+typedef struct ejTraceWriter {
+   FILE *fp;          // 輸出檔案
+   ejTraceHeader hdr; // 檔頭 (關閉時更新)
+   float *chunk;      // 目前區塊的緩衝區 (nColumns * chunkRows)
+   uint32_t fill;     // 目前區塊已填入的列數
+} ejTraceWriter;
+
+// 以 mmap 讀取的唯讀檔案
+typedef struct ejTraceReader {
+   const ejTraceHeader *hdr; // 檔頭 (指向映射區)
+   const unsigned char *base; // 映射區起始位置
+   size_t size;               // 映射區大小
+} ejTraceReader;
+
+//
+// Function Prototypes
+//
+// 寫入：成功回傳 0，失敗回傳 -1
+int ejTraceOpenWrite(ejTraceWriter*, const char*, const ejBuckSPECS*,
+                     const char*, double, int, const char* const*, uint32_t);
+int ejTraceAppend(ejTraceWriter*, const float*); // 附加一列 (nColumns 個值)
+int ejTraceClose(ejTraceWriter*);                // 寫入最後區塊、建立金字塔並更新檔頭
+
+// 讀取：資料皆直接指向映射區，不做複製
+int ejTraceOpenRead(ejTraceReader*, const char*);
+void ejTraceCloseRead(ejTraceReader*);
+int ejTraceFindColumn(const ejTraceReader*, const char*);
+const float* ejTraceChunk(const ejTraceReader*, int, uint64_t, uint32_t*);
+float ejTraceValue(const ejTraceReader*, int, uint64_t);
+const ejTraceMinMax* ejTraceLevel(const ejTraceReader*, int, int, uint64_t*);
+int ejTraceRange(const ejTraceReader*, int, uint64_t, uint64_t, int, ejTraceMinMax*);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRACE_H
+
+//
+// End of file
+//
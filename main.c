@@ -267,12 +267,21 @@ interrupt void adca1_isr(void)
 void ejBuckInitSetupCPU(ejBuckSPECS* buckSPECS, ejBuckInput* buckInput){
 
     // 設定電路參數
+#ifdef FIXEDSPECS
+    // 固定規格模式：與 CLA 折疊的常數保持一致
+    buckSPECS->L = FIXED_L;     // H, 電感值
+    buckSPECS->C = FIXED_C;     // F, 電容值
+    buckSPECS->r_L = FIXED_r_L; // ohm, 電感等效串聯電阻 (ESR)
+    buckSPECS->r_C = FIXED_r_C; // ohm, 電容等效串聯電阻 (ESR)
+    buckSPECS->f = FIXED_f;     // Hz, 切換頻率
+#else
     buckSPECS->L = 100e-6;  // H, 電感值
     buckSPECS->C = 100e-6;  // F, 電容值
     buckSPECS->r_L = 10e-3; // ohm, 電感等效串聯電阻 (ESR)
     buckSPECS->r_C = 1e-3;  // ohm, 電容等效串聯電阻 (ESR)
-    buckSPECS->R = 5;       // ohm, 負載電阻
     buckSPECS->f = 100e3;   // Hz, 切換頻率
+#endif
+    buckSPECS->R = 5;       // ohm, 負載電阻
 
     buckInput->v_i = 24;    // V, 輸入電壓
     buckInput->duty = 0.208;  // 工作週期 (Duty Cycle)
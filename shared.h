@@ -1,11 +1,29 @@
 
+#ifndef SHARED_H
+#define SHARED_H
+
 //
 // Included Files
 //
+#ifdef HOST_SIM
+// 主機端 (PC) 模擬：不引入裝置標頭檔，並將 CLA 專用的關鍵字定義為空
+#define __interrupt
+#define __mdebugstop()
+#else
 #include "F2837xD_device.h"
 #include "F2837xD_Cla_defines.h"
+#endif
 #include <stdint.h>
 
+//
+// Defines
+//
+//#define FIXEDSPECS // 啟用固定規格模式，L, C, r_L, r_C, f 取自 fixedspecs.h
+
+#ifdef FIXEDSPECS
+#include "fixedspecs.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -90,6 +108,7 @@ __interrupt void Cla1Task8(); // CLA 任務 8: 初始化 CLA 端的參數
 }
 #endif
 
+#endif // SHARED_H
 
 //
 // End of file